@@ -0,0 +1,107 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of the MotionGenerator. Besides the time per iteration, every benchmark reports
+// the heap allocations as allocs/op. Build with -DBUILD_BENCHMARKS=ON and run
+//   ros2 run franka_example_controllers motion_generator_benchmark
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#include <franka_example_controllers/motion_generator.hpp>
+
+namespace {
+thread_local size_t thread_allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  ++thread_allocations;
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /*size*/) noexcept {
+  std::free(pointer);
+}
+
+namespace {
+using Vector7d = MotionGenerator::Vector7d;
+
+const Vector7d kStart = (Vector7d() << 0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4).finished();
+const Vector7d kGoal = (Vector7d() << 0.5, 0, -0.5, -2, 0.5, 2, 0).finished();
+
+/// Reports the allocations of the calling thread during its lifetime as allocs/op.
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state)
+      : state_(state), allocations_at_start_(thread_allocations) {}
+
+  ~AllocationCounter() {
+    state_.counters["allocs/op"] =
+        benchmark::Counter(static_cast<double>(thread_allocations - allocations_at_start_),
+                           benchmark::Counter::kAvgIterations);
+  }
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+ private:
+  benchmark::State& state_;
+  size_t allocations_at_start_;
+};
+
+/// One call per control period over the whole motion, as in the move_to_start controller.
+void BM_GetDesiredJointPositions(benchmark::State& state) {
+  MotionGenerator generator(0.2, kStart, kGoal);
+  const auto kCycles = static_cast<int64_t>(generator.getDuration() * 1000);
+
+  AllocationCounter allocations(state);
+  int64_t cycle = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        generator.getDesiredJointPositions(rclcpp::Duration(std::chrono::milliseconds(cycle))));
+    cycle = cycle + 1 < kCycles ? cycle + 1 : 0;
+  }
+}
+BENCHMARK(BM_GetDesiredJointPositions);
+
+/// The whole motion on a grid of state.range(0) times.
+void BM_GetDesiredJointPositionsGrid(benchmark::State& state) {
+  const MotionGenerator kGenerator(0.2, kStart, kGoal);
+  const Eigen::VectorXd kTimes =
+      Eigen::VectorXd::LinSpaced(state.range(0), 0.0, kGenerator.getDuration());
+  Eigen::Matrix<double, 7, Eigen::Dynamic> joint_positions(7, kTimes.size());
+
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kGenerator.getDesiredJointPositions(kTimes, &joint_positions));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetDesiredJointPositionsGrid)->RangeMultiplier(10)->Range(10, 100000);
+
+}  // namespace
+
+BENCHMARK_MAIN();
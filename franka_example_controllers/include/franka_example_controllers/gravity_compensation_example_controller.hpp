@@ -20,6 +20,8 @@
 #include <rclcpp/duration.hpp>
 #include <rclcpp/time.hpp>
 
+#include "joint_handles.hpp"
+
 using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
 
 namespace franka_example_controllers {
@@ -36,9 +38,11 @@ class GravityCompensationExampleController : public controller_interface::Contro
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
   controller_interface::return_type update(const rclcpp::Time& time,
                                            const rclcpp::Duration& period) override;
+  CallbackReturn on_activate(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State& previous_state) override;
 
  private:
   std::string arm_id_;
-  const int num_joints = 7;
+  JointHandles joint_handles_{{}, "effort"};
 };
 }  // namespace franka_example_controllers
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <controller_interface/controller_interface.hpp>
+#include <hardware_interface/loaned_command_interface.hpp>
+#include <hardware_interface/loaned_state_interface.hpp>
+#include <rclcpp/logger.hpp>
+
+namespace franka_example_controllers {
+
+/**
+ * Interfaces of the seven joints of an arm, resolved once so that the control loop reads and
+ * writes them without building names or searching the claimed interfaces.
+ *
+ * The controller forwards its interface configurations to stateInterfaceConfiguration() and
+ * commandInterfaceConfiguration(), calls assign() in on_activate() and release() in
+ * on_deactivate(). In between, the read and write methods only follow the resolved pointers in
+ * joint order, independent of the order in which the controller_manager loaned the interfaces.
+ */
+class JointHandles {
+ public:
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+  static constexpr int kNumJoints = 7;
+
+  /**
+   * @param[in] state_interface_types state interfaces claimed for every joint, any of "position",
+   * "velocity" and "effort".
+   * @param[in] command_interface_type command interface claimed for every joint, e.g. "effort".
+   * Empty if the controller does not command the joints.
+   */
+  JointHandles(std::vector<std::string> state_interface_types, std::string command_interface_type);
+
+  /// @return the state interfaces of all joints of the arm, joint by joint.
+  controller_interface::InterfaceConfiguration stateInterfaceConfiguration(
+      const std::string& arm_id) const;
+
+  /// @return the command interfaces of all joints of the arm, in joint order.
+  controller_interface::InterfaceConfiguration commandInterfaceConfiguration(
+      const std::string& arm_id) const;
+
+  /**
+   * Looks up the configured interfaces of all joints. Not real-time safe.
+   * @param[in] arm_id the arm_id of the robot.
+   * @param[in] state_interfaces the state interfaces loaned to the controller.
+   * @param[in] command_interfaces the command interfaces loaned to the controller.
+   * @param[in] logger ROS Logger to report missing interfaces.
+   * @return false if an interface is missing.
+   */
+  bool assign(const std::string& arm_id,
+              const std::vector<hardware_interface::LoanedStateInterface>& state_interfaces,
+              std::vector<hardware_interface::LoanedCommandInterface>* command_interfaces,
+              const rclcpp::Logger& logger);
+
+  /// Forgets the resolved interfaces, e.g. before the controller_manager takes them back.
+  void release();
+
+  /// Reads the joint positions, only if "position" was configured.
+  void readPositions(Vector7d* q) const { read(position_, q); }
+
+  /// Reads the joint velocities, only if "velocity" was configured.
+  void readVelocities(Vector7d* dq) const { read(velocity_, dq); }
+
+  /// Reads the measured joint torques, only if "effort" was configured.
+  void readEfforts(Vector7d* tau) const { read(effort_, tau); }
+
+  /// Writes one command per joint, only if a command interface was configured.
+  void writeCommands(const Vector7d& command) {
+    for (int i = 0; i < kNumJoints; ++i) {
+      command_[i]->set_value(command(i));
+    }
+  }
+
+ private:
+  using StateHandles = std::array<const hardware_interface::LoanedStateInterface*, kNumJoints>;
+
+  static void read(const StateHandles& handles, Vector7d* values) {
+    for (int i = 0; i < kNumJoints; ++i) {
+      (*values)(i) = handles[i]->get_value();
+    }
+  }
+
+  /// @return the handles of the given state interface type, nullptr for unsupported types.
+  StateHandles* stateHandles(const std::string& interface_type);
+
+  const std::vector<std::string> state_interface_types_;
+  const std::string command_interface_type_;
+  StateHandles position_{};
+  StateHandles velocity_{};
+  StateHandles effort_{};
+  std::array<hardware_interface::LoanedCommandInterface*, kNumJoints> command_{};
+};
+
+}  // namespace franka_example_controllers
@@ -20,6 +20,9 @@
 #include <controller_interface/controller_interface.hpp>
 #include <rclcpp/rclcpp.hpp>
 
+#include "joint_handles.hpp"
+#include "low_pass_filter.hpp"
+
 using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
 
 namespace franka_example_controllers {
@@ -37,18 +40,19 @@ class JointImpedanceExampleController : public controller_interface::ControllerI
   CallbackReturn on_init() override;
   CallbackReturn on_configure(const rclcpp_lifecycle::State& previous_state) override;
   CallbackReturn on_activate(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State& previous_state) override;
 
  private:
   std::string arm_id_;
   const int num_joints = 7;
+  JointHandles joint_handles_{{"position", "velocity"}, "effort"};
   Vector7d q_;
   Vector7d initial_q_;
   Vector7d dq_;
-  Vector7d dq_filtered_;
+  LowPassFilter dq_filter_;
   Vector7d k_gains_;
   Vector7d d_gains_;
   rclcpp::Time start_time_;
-  void updateJointStates();
 };
 
 }  // namespace franka_example_controllers
\ No newline at end of file
@@ -0,0 +1,59 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Eigen/Core>
+
+namespace franka_example_controllers {
+
+/**
+ * First order low-pass filter of one value per joint:
+ *   output = (1 - alpha) * output + alpha * input
+ * alpha = 1 passes the input through, smaller values filter more strongly.
+ */
+class LowPassFilter {
+ public:
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+  /// @return true if alpha is in (0, 1].
+  static bool isValidAlpha(double alpha) { return alpha > 0.0 and alpha <= 1.0; }
+
+  /// @param[in] alpha weight of a new input, see isValidAlpha().
+  explicit LowPassFilter(double alpha = 1.0) : alpha_(alpha) {}
+
+  void setAlpha(double alpha) { alpha_ = alpha; }
+  double getAlpha() const { return alpha_; }
+
+  /// Sets the output, e.g. to zero before the controller starts.
+  void reset(const Vector7d& output = Vector7d::Zero()) { output_ = output; }
+
+  /**
+   * Filters one input.
+   * @param[in] input the new input, e.g. the measured joint velocities.
+   * @return the filtered output.
+   */
+  const Vector7d& update(const Vector7d& input) {
+    output_ = (1 - alpha_) * output_ + alpha_ * input;
+    return output_;
+  }
+
+  const Vector7d& getOutput() const { return output_; }
+
+ private:
+  double alpha_;
+  Vector7d output_ = Vector7d::Zero();
+};
+
+}  // namespace franka_example_controllers
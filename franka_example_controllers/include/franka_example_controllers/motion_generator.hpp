@@ -36,6 +36,9 @@ class MotionGenerator {
    */
   MotionGenerator(double speed_factor, const Vector7d& q_start, const Vector7d& q_goal);
 
+  /// Creates a MotionGenerator which stays at the zero position.
+  MotionGenerator() : MotionGenerator(1.0, Vector7d::Zero(), Vector7d::Zero()) {}
+
   /**
    * Sends joint position calculations
    *
@@ -47,8 +50,24 @@ class MotionGenerator {
    */
   std::pair<Vector7d, bool> getDesiredJointPositions(const rclcpp::Duration& trajectory_time);
 
+  /**
+   * Samples the joint positions of the whole motion on a grid of trajectory times at once, e.g. to
+   * validate a motion before executing it.
+   *
+   * @param[in] trajectory_times Times since the start of the trajectory in seconds.
+   * @param[out] joint_positions Joint positions, one column per time.
+   *
+   * @return whether the motion is finished at the last time.
+   */
+  bool getDesiredJointPositions(const Eigen::VectorXd& trajectory_times,
+                                Eigen::Matrix<double, 7, Eigen::Dynamic>* joint_positions) const;
+
+  /// @return the time in seconds after which all joints reached the goal.
+  double getDuration() const;
+
  private:
   using Vector7i = Eigen::Matrix<int, 7, 1>;
+  using Array7d = Eigen::Array<double, 7, 1>;
 
   bool calculateDesiredValues(double t, Vector7d* delta_q_d) const;
   void calculateSynchronizedValues();
@@ -59,11 +78,25 @@ class MotionGenerator {
   Vector7d q_start_;
   Vector7d delta_q_;
 
-  Vector7d dq_max_sync_;
-  Vector7d t_1_sync_;
-  Vector7d t_2_sync_;
-  Vector7d t_f_sync_;
-  Vector7d q_1_;
+  Vector7d dq_max_sync_ = Vector7d::Zero();
+  Vector7d t_1_sync_ = Vector7d::Zero();
+  Vector7d t_2_sync_ = Vector7d::Zero();
+  Vector7d t_f_sync_ = Vector7d::Zero();
+  Vector7d q_1_ = Vector7d::Zero();
+
+  // Constant terms of calculateDesiredValues(), computed once by calculateSynchronizedValues()
+  Eigen::Array<bool, 7, 1> joint_moves_ = Eigen::Array<bool, 7, 1>::Constant(false);
+  // dq_max_sync_ * sign(delta_q_)
+  Array7d signed_dq_max_sync_ = Array7d::Zero();
+  // t_2_sync_ - t_1_sync_
+  Array7d t_d_ = Array7d::Zero();
+  // t_f_sync_ - t_2_sync_
+  Array7d delta_t_2_sync_ = Array7d::Zero();
+  // 1 / t_1_sync_^3 and 1 / delta_t_2_sync_^3, zero for joints which do not move
+  Array7d inverse_t_1_sync_cubed_ = Array7d::Zero();
+  Array7d inverse_delta_t_2_sync_cubed_ = Array7d::Zero();
+  // latest t_f_sync_ of all moving joints
+  double t_f_max_ = 0.0;
 
   double time_ = 0.0;
 
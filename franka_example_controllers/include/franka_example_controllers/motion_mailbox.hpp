@@ -0,0 +1,79 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace franka_example_controllers {
+
+/**
+ * Lock-free hand over of the latest value from one non real-time thread to the control loop.
+ *
+ * Works like a triple buffer: the writer and the reader each own a slot and the third one is
+ * exchanged through a single atomic index. Values which are posted before the reader took the
+ * previous one replace it. Neither side blocks or allocates.
+ */
+template <typename T>
+class MotionMailbox {
+ public:
+  MotionMailbox() = default;
+  MotionMailbox(const MotionMailbox&) = delete;
+  MotionMailbox& operator=(const MotionMailbox&) = delete;
+
+  /**
+   * Hands value over to the reader. Writer side only.
+   * @param[in] value the value to post.
+   */
+  void post(const T& value) {
+    slots_.at(write_index_) = value;
+    const auto kPosted = static_cast<uint8_t>(write_index_ | kNewValueFlag);
+    write_index_ = static_cast<uint8_t>(middle_.exchange(kPosted, std::memory_order_acq_rel) &
+                                        kIndexMask);
+  }
+
+  /**
+   * Takes the latest posted value, if a new one was posted. Reader side only.
+   * @param[out] value the posted value, only written if there is a new one.
+   * @return true if a value was posted since the last call.
+   */
+  bool take(T* value) {
+    if ((middle_.load(std::memory_order_relaxed) & kNewValueFlag) == 0) {
+      return false;
+    }
+    read_index_ =
+        static_cast<uint8_t>(middle_.exchange(read_index_, std::memory_order_acq_rel) & kIndexMask);
+    *value = slots_.at(read_index_);
+    return true;
+  }
+
+  /// Drops a posted value which was not taken yet. Reader side only.
+  void clear() {
+    T discarded;
+    take(&discarded);
+  }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kNewValueFlag = 0x4;
+
+  std::array<T, 3> slots_{};
+  std::atomic<uint8_t> middle_{1};
+  uint8_t write_index_ = 0;
+  uint8_t read_index_ = 2;
+};
+
+}  // namespace franka_example_controllers
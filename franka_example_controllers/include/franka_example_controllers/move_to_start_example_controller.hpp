@@ -20,14 +20,19 @@
 #include <Eigen/Eigen>
 #include <controller_interface/controller_interface.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <std_msgs/msg/float64_multi_array.hpp>
 
-#include "motion_generator.hpp"
+#include "joint_handles.hpp"
+#include "low_pass_filter.hpp"
+#include "motion_mailbox.hpp"
+#include "replanning_motion_generator.hpp"
 
 using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
 
 namespace franka_example_controllers {
 
-/// The move to start example controller moves the robot into default pose.
+/// The move to start example controller moves the robot into default pose. Afterwards it moves to
+/// every goal received on ~/joint_goal, also while it is still moving.
 class MoveToStartExampleController : public controller_interface::ControllerInterface {
  public:
   using Vector7d = Eigen::Matrix<double, 7, 1>;
@@ -38,19 +43,23 @@ class MoveToStartExampleController : public controller_interface::ControllerInte
   CallbackReturn on_init() override;
   CallbackReturn on_configure(const rclcpp_lifecycle::State& previous_state) override;
   CallbackReturn on_activate(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State& previous_state) override;
 
  private:
   std::string arm_id_;
   const int num_joints = 7;
+  JointHandles joint_handles_{{"position", "velocity"}, "effort"};
   Vector7d q_;
   Vector7d q_goal_;
   Vector7d dq_;
-  Vector7d dq_filtered_;
+  LowPassFilter dq_filter_;
   Vector7d k_gains_;
   Vector7d d_gains_;
-  rclcpp::Time start_time_;
-  std::unique_ptr<MotionGenerator> motion_generator_;
-
-  void updateJointStates();
+  double speed_factor_ = 0.2;
+  ReplanningMotionGenerator motion_generator_;
+  rclcpp::Subscription<std_msgs::msg::Float64MultiArray>::SharedPtr goal_subscription_;
+  MotionMailbox<MotionGoal> goal_mailbox_;
+  MotionGoal pending_goal_;
+  bool has_pending_goal_ = false;
 };
 }  // namespace franka_example_controllers
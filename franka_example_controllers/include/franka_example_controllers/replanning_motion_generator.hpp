@@ -0,0 +1,98 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include <Eigen/Core>
+#include <rclcpp/time.hpp>
+
+#include "motion_generator.hpp"
+
+namespace franka_example_controllers {
+
+/// Goal of a ReplanningMotionGenerator, e.g. handed over through a MotionMailbox.
+struct MotionGoal {
+  MotionGenerator::Vector7d q_goal = MotionGenerator::Vector7d::Zero();
+  /// General speed factor in range (0, 1].
+  double speed_factor = 0.2;
+};
+
+/**
+ * Joint motion which can be sent to a new goal at any time, also while it is moving.
+ *
+ * A new goal starts a MotionGenerator from the previous goal to the new goal, which is added to
+ * the motions that are still running. Since every MotionGenerator starts and ends with zero
+ * velocity and acceleration, the desired positions, velocities and accelerations stay continuous.
+ * Velocities of overlapping motions add up, so they can exceed the limits of a single
+ * MotionGenerator for the time of the overlap.
+ *
+ * All methods run in bounded time and do not allocate, so they can be called from the control
+ * loop.
+ */
+class ReplanningMotionGenerator {
+ public:
+  using Vector7d = MotionGenerator::Vector7d;
+
+  /// Maximum number of overlapping motions, setGoal() fails while this many are running.
+  static constexpr size_t kMaxMotions = 4;
+
+  /**
+   * Stops all motions and holds q.
+   *
+   * @param[in] q Joint positions to hold.
+   */
+  void reset(const Vector7d& q);
+
+  /**
+   * Starts a motion from the current goal to a new goal.
+   *
+   * @param[in] goal New goal.
+   * @param[in] time Start time of the motion.
+   *
+   * @return false if kMaxMotions motions are still running, then the goal is not taken.
+   */
+  bool setGoal(const MotionGoal& goal, const rclcpp::Time& time);
+
+  /**
+   * Calculates the sum of all motions. Finished motions are removed.
+   *
+   * @param[in] time Current time, on the same clock as the times given to setGoal().
+   *
+   * @return Joint positions to use inside a control loop and a boolean indicating whether all
+   * motions are finished.
+   */
+  std::pair<Vector7d, bool> getDesiredJointPositions(const rclcpp::Time& time);
+
+  /// @return the goal of the last motion, or the held position.
+  const Vector7d& getGoal() const { return q_goal_; }
+
+ private:
+  struct Motion {
+    MotionGenerator generator;
+    rclcpp::Time start_time;
+    Vector7d delta_q = Vector7d::Zero();
+  };
+
+  // Joint positions before the first running motion
+  Vector7d q_base_ = Vector7d::Zero();
+  Vector7d q_goal_ = Vector7d::Zero();
+  std::array<Motion, kMaxMotions> motions_{};
+  size_t motion_count_ = 0;
+};
+
+}  // namespace franka_example_controllers
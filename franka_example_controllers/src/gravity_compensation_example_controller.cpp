@@ -21,29 +21,36 @@ namespace franka_example_controllers {
 
 controller_interface::InterfaceConfiguration
 GravityCompensationExampleController::command_interface_configuration() const {
-  controller_interface::InterfaceConfiguration config;
-  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-
-  for (int i = 1; i <= num_joints; ++i) {
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/effort");
-  }
-  return config;
+  return joint_handles_.commandInterfaceConfiguration(arm_id_);
 }
 
 controller_interface::InterfaceConfiguration
 GravityCompensationExampleController::state_interface_configuration() const {
-  return {};
+  return joint_handles_.stateInterfaceConfiguration(arm_id_);
 }
 
 controller_interface::return_type GravityCompensationExampleController::update(
     const rclcpp::Time& /*time*/,
     const rclcpp::Duration& /*period*/) {
-  for (auto& command_interface : command_interfaces_) {
-    command_interface.set_value(0);
-  }
+  joint_handles_.writeCommands(JointHandles::Vector7d::Zero());
   return controller_interface::return_type::OK;
 }
 
+CallbackReturn GravityCompensationExampleController::on_activate(
+    const rclcpp_lifecycle::State& /*previous_state*/) {
+  if (not joint_handles_.assign(arm_id_, state_interfaces_, &command_interfaces_,
+                                node_->get_logger())) {
+    return CallbackReturn::ERROR;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn GravityCompensationExampleController::on_deactivate(
+    const rclcpp_lifecycle::State& /*previous_state*/) {
+  joint_handles_.release();
+  return CallbackReturn::SUCCESS;
+}
+
 CallbackReturn GravityCompensationExampleController::on_configure(
     const rclcpp_lifecycle::State& /*previous_state*/) {
   arm_id_ = node_->get_parameter("arm_id").as_string();
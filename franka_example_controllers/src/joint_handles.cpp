@@ -0,0 +1,132 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_example_controllers/joint_handles.hpp>
+
+#include <string>
+#include <utility>
+
+#include <rclcpp/logging.hpp>
+
+namespace franka_example_controllers {
+
+namespace {
+std::string jointName(const std::string& arm_id, int index) {
+  return arm_id + "_joint" + std::to_string(index + 1);
+}
+
+/// @return the interface of the joint in interfaces, nullptr if it is not there.
+template <typename Interfaces>
+auto findInterface(Interfaces& interfaces,
+                   const std::string& joint_name,
+                   const std::string& interface_type) -> decltype(&interfaces.front()) {
+  for (auto& interface : interfaces) {
+    if (interface.get_name() == joint_name and interface.get_interface_name() == interface_type) {
+      return &interface;
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+JointHandles::JointHandles(std::vector<std::string> state_interface_types,
+                           std::string command_interface_type)
+    : state_interface_types_(std::move(state_interface_types)),
+      command_interface_type_(std::move(command_interface_type)) {}
+
+controller_interface::InterfaceConfiguration JointHandles::stateInterfaceConfiguration(
+    const std::string& arm_id) const {
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (int i = 0; i < kNumJoints; ++i) {
+    for (const auto& interface_type : state_interface_types_) {
+      config.names.push_back(jointName(arm_id, i) + "/" + interface_type);
+    }
+  }
+  return config;
+}
+
+controller_interface::InterfaceConfiguration JointHandles::commandInterfaceConfiguration(
+    const std::string& arm_id) const {
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  if (command_interface_type_.empty()) {
+    return config;
+  }
+  for (int i = 0; i < kNumJoints; ++i) {
+    config.names.push_back(jointName(arm_id, i) + "/" + command_interface_type_);
+  }
+  return config;
+}
+
+bool JointHandles::assign(
+    const std::string& arm_id,
+    const std::vector<hardware_interface::LoanedStateInterface>& state_interfaces,
+    std::vector<hardware_interface::LoanedCommandInterface>* command_interfaces,
+    const rclcpp::Logger& logger) {
+  release();
+  for (const auto& interface_type : state_interface_types_) {
+    StateHandles* handles = stateHandles(interface_type);
+    if (handles == nullptr) {
+      RCLCPP_FATAL(logger,
+                   "Unsupported state interface '%s'. Expected 'position', 'velocity' or 'effort'",
+                   interface_type.c_str());
+      return false;
+    }
+    for (int i = 0; i < kNumJoints; ++i) {
+      (*handles)[i] = findInterface(state_interfaces, jointName(arm_id, i), interface_type);
+      if ((*handles)[i] == nullptr) {
+        RCLCPP_FATAL(logger, "State interface %s/%s is not claimed", jointName(arm_id, i).c_str(),
+                     interface_type.c_str());
+        release();
+        return false;
+      }
+    }
+  }
+  if (command_interface_type_.empty()) {
+    return true;
+  }
+  for (int i = 0; i < kNumJoints; ++i) {
+    command_[i] = findInterface(*command_interfaces, jointName(arm_id, i), command_interface_type_);
+    if (command_[i] == nullptr) {
+      RCLCPP_FATAL(logger, "Command interface %s/%s is not claimed", jointName(arm_id, i).c_str(),
+                   command_interface_type_.c_str());
+      release();
+      return false;
+    }
+  }
+  return true;
+}
+
+void JointHandles::release() {
+  position_.fill(nullptr);
+  velocity_.fill(nullptr);
+  effort_.fill(nullptr);
+  command_.fill(nullptr);
+}
+
+JointHandles::StateHandles* JointHandles::stateHandles(const std::string& interface_type) {
+  if (interface_type == "position") {
+    return &position_;
+  }
+  if (interface_type == "velocity") {
+    return &velocity_;
+  }
+  if (interface_type == "effort") {
+    return &effort_;
+  }
+  return nullptr;
+}
+
+}  // namespace franka_example_controllers
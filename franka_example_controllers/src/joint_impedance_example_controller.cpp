@@ -14,7 +14,6 @@
 
 #include <franka_example_controllers/joint_impedance_example_controller.hpp>
 
-#include <cassert>
 #include <cmath>
 #include <exception>
 #include <string>
@@ -25,43 +24,29 @@ namespace franka_example_controllers {
 
 controller_interface::InterfaceConfiguration
 JointImpedanceExampleController::command_interface_configuration() const {
-  controller_interface::InterfaceConfiguration config;
-  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-
-  for (int i = 1; i <= num_joints; ++i) {
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/effort");
-  }
-  return config;
+  return joint_handles_.commandInterfaceConfiguration(arm_id_);
 }
 
 controller_interface::InterfaceConfiguration
 JointImpedanceExampleController::state_interface_configuration() const {
-  controller_interface::InterfaceConfiguration config;
-  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  for (int i = 1; i <= num_joints; ++i) {
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/position");
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/velocity");
-  }
-  return config;
+  return joint_handles_.stateInterfaceConfiguration(arm_id_);
 }
 
 controller_interface::return_type JointImpedanceExampleController::update(
     const rclcpp::Time& /*time*/,
     const rclcpp::Duration& /*period*/) {
-  updateJointStates();
+  joint_handles_.readPositions(&q_);
+  joint_handles_.readVelocities(&dq_);
   Vector7d q_goal = initial_q_;
   auto time = this->node_->now() - start_time_;
   double delta_angle = M_PI / 8.0 * (1 - std::cos(M_PI / 2.5 * time.seconds()));
   q_goal(3) += delta_angle;
   q_goal(4) += delta_angle;
 
-  const double kAlpha = 0.99;
-  dq_filtered_ = (1 - kAlpha) * dq_filtered_ + kAlpha * dq_;
+  const Vector7d& dq_filtered = dq_filter_.update(dq_);
   Vector7d tau_d_calculated =
-      k_gains_.cwiseProduct(q_goal - q_) + d_gains_.cwiseProduct(-dq_filtered_);
-  for (int i = 0; i < num_joints; ++i) {
-    command_interfaces_[i].set_value(tau_d_calculated(i));
-  }
+      k_gains_.cwiseProduct(q_goal - q_) + d_gains_.cwiseProduct(-dq_filtered);
+  joint_handles_.writeCommands(tau_d_calculated);
   return controller_interface::return_type::OK;
 }
 
@@ -70,6 +55,7 @@ CallbackReturn JointImpedanceExampleController::on_init() {
     auto_declare<std::string>("arm_id", "panda");
     auto_declare<std::vector<double>>("k_gains", {});
     auto_declare<std::vector<double>>("d_gains", {});
+    auto_declare<double>("dq_filter_alpha", 0.99);
   } catch (const std::exception& e) {
     fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
     return CallbackReturn::ERROR;
@@ -104,29 +90,32 @@ CallbackReturn JointImpedanceExampleController::on_configure(
     d_gains_(i) = d_gains.at(i);
     k_gains_(i) = k_gains.at(i);
   }
-  dq_filtered_.setZero();
+  const double kDqFilterAlpha = node_->get_parameter("dq_filter_alpha").as_double();
+  if (not LowPassFilter::isValidAlpha(kDqFilterAlpha)) {
+    RCLCPP_FATAL(node_->get_logger(), "dq_filter_alpha should be in (0, 1] but is %f",
+                 kDqFilterAlpha);
+    return CallbackReturn::FAILURE;
+  }
+  dq_filter_.setAlpha(kDqFilterAlpha);
   return CallbackReturn::SUCCESS;
 }
 
 CallbackReturn JointImpedanceExampleController::on_activate(
     const rclcpp_lifecycle::State& /*previous_state*/) {
-  updateJointStates();
-  initial_q_ = q_;
+  if (not joint_handles_.assign(arm_id_, state_interfaces_, &command_interfaces_,
+                                node_->get_logger())) {
+    return CallbackReturn::ERROR;
+  }
+  joint_handles_.readPositions(&initial_q_);
+  dq_filter_.reset();
   start_time_ = this->node_->now();
   return CallbackReturn::SUCCESS;
 }
 
-void JointImpedanceExampleController::updateJointStates() {
-  for (auto i = 0; i < num_joints; ++i) {
-    const auto& position_interface = state_interfaces_.at(2 * i);
-    const auto& velocity_interface = state_interfaces_.at(2 * i + 1);
-
-    assert(position_interface.get_interface_name() == "position");
-    assert(velocity_interface.get_interface_name() == "velocity");
-
-    q_(i) = position_interface.get_value();
-    dq_(i) = velocity_interface.get_value();
-  }
+CallbackReturn JointImpedanceExampleController::on_deactivate(
+    const rclcpp_lifecycle::State& /*previous_state*/) {
+  joint_handles_.release();
+  return CallbackReturn::SUCCESS;
 }
 
 }  // namespace franka_example_controllers
@@ -14,8 +14,6 @@
 
 #include <franka_example_controllers/motion_generator.hpp>
 
-#include <algorithm>
-#include <array>
 #include <cassert>
 #include <cmath>
 #include <utility>
@@ -36,38 +34,28 @@ MotionGenerator::MotionGenerator(double speed_factor,
 }
 
 bool MotionGenerator::calculateDesiredValues(double t, Vector7d* delta_q_d) const {
-  Vector7i sign_delta_q;
-  sign_delta_q << delta_q_.cwiseSign().cast<int>();
-  Vector7d t_d = t_2_sync_ - t_1_sync_;
-  Vector7d delta_t_2_sync = t_f_sync_ - t_2_sync_;
-  std::array<bool, kJoints> joint_motion_finished{};
+  // All phases are evaluated for all joints and the valid one is selected per joint, which
+  // vectorizes instead of branching per joint.
+  const Array7d t_1 = t_1_sync_.array();
+  const Array7d acceleration =
+      -inverse_t_1_sync_cubed_ * signed_dq_max_sync_ * (0.5 * t - t_1) * (t * t * t);
+  const Array7d constant_velocity = q_1_.array() + (t - t_1) * signed_dq_max_sync_;
+  const Array7d t_deceleration = t - t_1 - t_d_;
+  const Array7d deceleration =
+      delta_q_.array() +
+      0.5 *
+          (inverse_delta_t_2_sync_cubed_ * (t_deceleration - 2.0 * delta_t_2_sync_) *
+               t_deceleration.cube() +
+           (2.0 * t_deceleration - delta_t_2_sync_)) *
+          signed_dq_max_sync_;
 
-  for (auto i = 0; i < kJoints; i++) {
-    if (std::abs(delta_q_[i]) < kDeltaQMotionFinished) {
-      (*delta_q_d)[i] = 0;
-      joint_motion_finished.at(i) = true;
-    } else {
-      if (t < t_1_sync_[i]) {
-        (*delta_q_d)[i] = -1.0 / std::pow(t_1_sync_[i], 3.0) * dq_max_sync_[i] * sign_delta_q[i] *
-                          (0.5 * t - t_1_sync_[i]) * std::pow(t, 3.0);
-      } else if (t >= t_1_sync_[i] && t < t_2_sync_[i]) {
-        (*delta_q_d)[i] = q_1_[i] + (t - t_1_sync_[i]) * dq_max_sync_[i] * sign_delta_q[i];
-      } else if (t >= t_2_sync_[i] && t < t_f_sync_[i]) {
-        (*delta_q_d)[i] =
-            delta_q_[i] + 0.5 *
-                              (1.0 / std::pow(delta_t_2_sync[i], 3.0) *
-                                   (t - t_1_sync_[i] - 2.0 * delta_t_2_sync[i] - t_d[i]) *
-                                   std::pow((t - t_1_sync_[i] - t_d[i]), 3.0) +
-                               (2.0 * t - 2.0 * t_1_sync_[i] - delta_t_2_sync[i] - 2.0 * t_d[i])) *
-                              dq_max_sync_[i] * sign_delta_q[i];
-      } else {
-        (*delta_q_d)[i] = delta_q_[i];
-        joint_motion_finished.at(i) = true;
-      }
-    }
-  }
-  return std::all_of(joint_motion_finished.cbegin(), joint_motion_finished.cend(),
-                     [](bool x) { return x; });
+  const Array7d phase =
+      (t < t_1).select(acceleration,
+                       (t < t_2_sync_.array())
+                           .select(constant_velocity, (t < t_f_sync_.array())
+                                                          .select(deceleration, delta_q_.array())));
+  *delta_q_d = joint_moves_.select(phase, 0.0).matrix();
+  return t >= t_f_max_;
 }
 
 void MotionGenerator::calculateSynchronizedValues() {
@@ -111,6 +99,14 @@ void MotionGenerator::calculateSynchronizedValues() {
       q_1_[i] = (dq_max_sync_)[i] * sign_delta_q[i] * (0.5 * (t_1_sync_)[i]);
     }
   }
+
+  joint_moves_ = delta_q_.array().abs() >= kDeltaQMotionFinished;
+  signed_dq_max_sync_ = dq_max_sync_.array() * sign_delta_q.cast<double>().array();
+  t_d_ = t_2_sync_.array() - t_1_sync_.array();
+  delta_t_2_sync_ = t_f_sync_.array() - t_2_sync_.array();
+  inverse_t_1_sync_cubed_ = joint_moves_.select(t_1_sync_.array().cube().inverse(), 0.0);
+  inverse_delta_t_2_sync_cubed_ = joint_moves_.select(delta_t_2_sync_.cube().inverse(), 0.0);
+  t_f_max_ = joint_moves_.select(t_f_sync_.array(), 0.0).maxCoeff();
 }
 
 std::pair<MotionGenerator::Vector7d, bool> MotionGenerator::getDesiredJointPositions(
@@ -119,8 +115,22 @@ std::pair<MotionGenerator::Vector7d, bool> MotionGenerator::getDesiredJointPosit
 
   Vector7d delta_q_d;
   bool motion_finished = calculateDesiredValues(time_, &delta_q_d);
-
-  std::array<double, kJoints> joint_positions{};
-  Eigen::VectorXd::Map(&joint_positions[0], kJoints) = (q_start_ + delta_q_d);
   return std::make_pair(q_start_ + delta_q_d, motion_finished);
-}
\ No newline at end of file
+}
+
+bool MotionGenerator::getDesiredJointPositions(
+    const Eigen::VectorXd& trajectory_times,
+    Eigen::Matrix<double, 7, Eigen::Dynamic>* joint_positions) const {
+  joint_positions->resize(kJoints, trajectory_times.size());
+  bool motion_finished = false;
+  Vector7d delta_q_d;
+  for (Eigen::Index i = 0; i < trajectory_times.size(); i++) {
+    motion_finished = calculateDesiredValues(trajectory_times[i], &delta_q_d);
+    joint_positions->col(i) = q_start_ + delta_q_d;
+  }
+  return motion_finished;
+}
+
+double MotionGenerator::getDuration() const {
+  return t_f_max_;
+}
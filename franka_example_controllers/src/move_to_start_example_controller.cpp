@@ -14,7 +14,6 @@
 
 #include <franka_example_controllers/move_to_start_example_controller.hpp>
 
-#include <cassert>
 #include <cmath>
 #include <exception>
 
@@ -25,46 +24,38 @@ namespace franka_example_controllers {
 
 controller_interface::InterfaceConfiguration
 MoveToStartExampleController::command_interface_configuration() const {
-  controller_interface::InterfaceConfiguration config;
-  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-
-  for (int i = 1; i <= num_joints; ++i) {
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/effort");
-  }
-  return config;
+  return joint_handles_.commandInterfaceConfiguration(arm_id_);
 }
 
 controller_interface::InterfaceConfiguration
 MoveToStartExampleController::state_interface_configuration() const {
-  controller_interface::InterfaceConfiguration config;
-  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  for (int i = 1; i <= num_joints; ++i) {
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/position");
-    config.names.push_back(arm_id_ + "_joint" + std::to_string(i) + "/velocity");
-  }
-  return config;
+  return joint_handles_.stateInterfaceConfiguration(arm_id_);
 }
 
 controller_interface::return_type MoveToStartExampleController::update(
-    const rclcpp::Time& /*time*/,
+    const rclcpp::Time& time,
     const rclcpp::Duration& /*period*/) {
-  updateJointStates();
-  auto trajectory_time = this->node_->now() - start_time_;
-  auto motion_generator_output = motion_generator_->getDesiredJointPositions(trajectory_time);
+  joint_handles_.readPositions(&q_);
+  joint_handles_.readVelocities(&dq_);
+  has_pending_goal_ = goal_mailbox_.take(&pending_goal_) or has_pending_goal_;
+  if (has_pending_goal_) {
+    if (motion_generator_.getDesiredJointPositions(time).second) {
+      // the robot is not commanded at rest, start from where it is
+      motion_generator_.reset(q_);
+    }
+    // waits for a running motion to finish if too many are running
+    has_pending_goal_ = not motion_generator_.setGoal(pending_goal_, time);
+  }
+  auto motion_generator_output = motion_generator_.getDesiredJointPositions(time);
   Vector7d q_desired = motion_generator_output.first;
   bool finished = motion_generator_output.second;
   if (not finished) {
-    const double kAlpha = 0.99;
-    dq_filtered_ = (1 - kAlpha) * dq_filtered_ + kAlpha * dq_;
+    const Vector7d& dq_filtered = dq_filter_.update(dq_);
     Vector7d tau_d_calculated =
-        k_gains_.cwiseProduct(q_desired - q_) + d_gains_.cwiseProduct(-dq_filtered_);
-    for (int i = 0; i < 7; ++i) {
-      command_interfaces_[i].set_value(tau_d_calculated(i));
-    }
+        k_gains_.cwiseProduct(q_desired - q_) + d_gains_.cwiseProduct(-dq_filtered);
+    joint_handles_.writeCommands(tau_d_calculated);
   } else {
-    for (auto& command_interface : command_interfaces_) {
-      command_interface.set_value(0);
-    }
+    joint_handles_.writeCommands(Vector7d::Zero());
   }
   return controller_interface::return_type::OK;
 }
@@ -75,6 +66,10 @@ CallbackReturn MoveToStartExampleController::on_init() {
     auto_declare<std::string>("arm_id", "panda");
     auto_declare<std::vector<double>>("k_gains", {});
     auto_declare<std::vector<double>>("d_gains", {});
+    auto_declare<std::vector<double>>("q_goal",
+                                      std::vector<double>(q_goal_.data(), q_goal_.data() + 7));
+    auto_declare<double>("speed_factor", speed_factor_);
+    auto_declare<double>("dq_filter_alpha", 0.99);
   } catch (const std::exception& e) {
     fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
     return CallbackReturn::ERROR;
@@ -109,29 +104,63 @@ CallbackReturn MoveToStartExampleController::on_configure(
     d_gains_(i) = d_gains.at(i);
     k_gains_(i) = k_gains.at(i);
   }
-  dq_filtered_.setZero();
+  auto q_goal = node_->get_parameter("q_goal").as_double_array();
+  if (q_goal.size() != static_cast<uint>(num_joints)) {
+    RCLCPP_FATAL(node_->get_logger(), "q_goal should be of size %d but is of size %ld", num_joints,
+                 q_goal.size());
+    return CallbackReturn::FAILURE;
+  }
+  q_goal_ = Vector7d::Map(q_goal.data());
+  speed_factor_ = node_->get_parameter("speed_factor").as_double();
+  if (speed_factor_ <= 0.0 or speed_factor_ > 1.0) {
+    RCLCPP_FATAL(node_->get_logger(), "speed_factor should be in (0, 1] but is %f", speed_factor_);
+    return CallbackReturn::FAILURE;
+  }
+  const double kDqFilterAlpha = node_->get_parameter("dq_filter_alpha").as_double();
+  if (not LowPassFilter::isValidAlpha(kDqFilterAlpha)) {
+    RCLCPP_FATAL(node_->get_logger(), "dq_filter_alpha should be in (0, 1] but is %f",
+                 kDqFilterAlpha);
+    return CallbackReturn::FAILURE;
+  }
+  dq_filter_.setAlpha(kDqFilterAlpha);
+
+  goal_subscription_ = node_->create_subscription<std_msgs::msg::Float64MultiArray>(
+      "~/joint_goal", rclcpp::SystemDefaultsQoS(),
+      [this](const std_msgs::msg::Float64MultiArray::SharedPtr msg) {
+        if (msg->data.size() != static_cast<uint>(num_joints)) {
+          RCLCPP_WARN(node_->get_logger(), "Ignoring joint goal with %zu instead of %d values",
+                      msg->data.size(), num_joints);
+          return;
+        }
+        MotionGoal goal;
+        goal.q_goal = Vector7d::Map(msg->data.data());
+        goal.speed_factor = speed_factor_;
+        goal_mailbox_.post(goal);
+      });
   return CallbackReturn::SUCCESS;
 }
 
 CallbackReturn MoveToStartExampleController::on_activate(
     const rclcpp_lifecycle::State& /*previous_state*/) {
-  updateJointStates();
-  motion_generator_ = std::make_unique<MotionGenerator>(0.2, q_, q_goal_);
-  start_time_ = this->node_->now();
+  if (not joint_handles_.assign(arm_id_, state_interfaces_, &command_interfaces_,
+                                node_->get_logger())) {
+    return CallbackReturn::ERROR;
+  }
+  joint_handles_.readPositions(&q_);
+  dq_filter_.reset();
+  goal_mailbox_.clear();
+  motion_generator_.reset(q_);
+  // started by the first update(), on the clock of the controller_manager
+  pending_goal_.q_goal = q_goal_;
+  pending_goal_.speed_factor = speed_factor_;
+  has_pending_goal_ = true;
   return CallbackReturn::SUCCESS;
 }
 
-void MoveToStartExampleController::updateJointStates() {
-  for (auto i = 0; i < num_joints; ++i) {
-    const auto& position_interface = state_interfaces_.at(2 * i);
-    const auto& velocity_interface = state_interfaces_.at(2 * i + 1);
-
-    assert(position_interface.get_interface_name() == "position");
-    assert(velocity_interface.get_interface_name() == "velocity");
-
-    q_(i) = position_interface.get_value();
-    dq_(i) = velocity_interface.get_value();
-  }
+CallbackReturn MoveToStartExampleController::on_deactivate(
+    const rclcpp_lifecycle::State& /*previous_state*/) {
+  joint_handles_.release();
+  return CallbackReturn::SUCCESS;
 }
 }  // namespace franka_example_controllers
 #include "pluginlib/class_list_macros.hpp"
@@ -0,0 +1,63 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_example_controllers/replanning_motion_generator.hpp>
+
+#include <utility>
+
+namespace franka_example_controllers {
+
+void ReplanningMotionGenerator::reset(const Vector7d& q) {
+  q_base_ = q;
+  q_goal_ = q;
+  motion_count_ = 0;
+}
+
+bool ReplanningMotionGenerator::setGoal(const MotionGoal& goal, const rclcpp::Time& time) {
+  if (motion_count_ == kMaxMotions) {
+    return false;
+  }
+  auto& motion = motions_.at(motion_count_);
+  motion.delta_q = goal.q_goal - q_goal_;
+  motion.generator = MotionGenerator(goal.speed_factor, Vector7d::Zero(), motion.delta_q);
+  motion.start_time = time;
+  motion_count_++;
+  q_goal_ = goal.q_goal;
+  return true;
+}
+
+std::pair<ReplanningMotionGenerator::Vector7d, bool>
+ReplanningMotionGenerator::getDesiredJointPositions(const rclcpp::Time& time) {
+  Vector7d q_desired = q_base_;
+  size_t running = 0;
+  for (size_t i = 0; i < motion_count_; i++) {
+    auto& motion = motions_.at(i);
+    const auto kOutput = motion.generator.getDesiredJointPositions(time - motion.start_time);
+    if (kOutput.second and running == 0) {
+      // finished motions before the first running one are folded into the base
+      q_base_ += motion.delta_q;
+      q_desired += motion.delta_q;
+      continue;
+    }
+    q_desired += kOutput.first;
+    if (running != i) {
+      motions_.at(running) = motion;
+    }
+    running++;
+  }
+  motion_count_ = running;
+  return std::make_pair(q_desired, running == 0);
+}
+
+}  // namespace franka_example_controllers
@@ -14,9 +14,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <functional>
-#include <future>
 #include <memory>
 #include <string>
 #include <thread>
@@ -33,17 +33,10 @@
 #include <sensor_msgs/msg/joint_state.hpp>
 #include <std_srvs/srv/trigger.hpp>
 
-namespace franka_gripper {
+#include "gripper_command_executor.hpp"
+#include "seqlock.hpp"
 
-/// checks whether an asynchronous command has finished
-/// @tparam T the expected return type of the future
-/// @param t the future which should be checked
-/// @param future_wait_timeout how long to wait for the result before returning false
-/// @return whether the asynchronous function has already finished
-template <typename T>
-bool resultIsReady(std::future<T>& t, std::chrono::nanoseconds future_wait_timeout) {
-  return t.wait_for(future_wait_timeout) == std::future_status::ready;
-}
+namespace franka_gripper {
 
 /// ROS node that offers multiple actions to use the gripper.
 class GripperActionServer : public rclcpp::Node {
@@ -66,7 +59,18 @@ class GripperActionServer : public rclcpp::Node {
   /// @param options options for node initialization
   explicit GripperActionServer(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 
+  /// stops reading the gripper state
+  ~GripperActionServer() override;
+
  private:
+  /// the parts of franka::GripperState that are used, in a form that can be stored in a SeqLock
+  struct GripperStateSnapshot {
+    double width = 0.0;
+    double max_width = 0.0;
+    bool is_grasped = false;
+    uint16_t temperature = 0;
+  };
+
   /// describes the different tasks. Each task corresponds to one action server
   enum class Task { kHoming, kMove, kGrasp, kGripperCommand };
 
@@ -90,6 +94,7 @@ class GripperActionServer : public rclcpp::Node {
   const double k_default_speed = 0.1;              // default gripper speed in m/s
   const int k_default_state_publish_rate = 30;     // default gripper state publish rate
   const int k_default_feedback_publish_rate = 10;  // default action feedback publish rate
+  const int k_default_command_queue_size = 4;      // default number of goals that can wait
 
   std::unique_ptr<franka::Gripper> gripper_;
   rclcpp_action::Server<Homing>::SharedPtr homing_server_;
@@ -97,18 +102,22 @@ class GripperActionServer : public rclcpp::Node {
   rclcpp_action::Server<Grasp>::SharedPtr grasp_server_;
   rclcpp_action::Server<GripperCommand>::SharedPtr gripper_command_server_;
   rclcpp::Service<Trigger>::SharedPtr stop_service_;
-  std::mutex gripper_state_mutex_;
-  franka::GripperState current_gripper_state_;
+  std::unique_ptr<GripperCommandExecutor> command_executor_;
+  rclcpp::TimerBase::SharedPtr feedback_timer_;
+  SeqLock<GripperStateSnapshot> gripper_state_;
   rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr joint_states_publisher_;
-  rclcpp::TimerBase::SharedPtr timer_;
+  std::chrono::nanoseconds state_publish_period_{0};
+  std::thread gripper_state_thread_;
+  std::atomic<bool> stop_gripper_state_thread_{false};
 
   double default_speed_;          // default gripper speed parameter value in m/s
   double default_epsilon_inner_;  // default gripper inner epsilon parameter value in m
   double default_epsilon_outer_;  //  default gripper outer epsilon parameter value in m
   std::vector<std::string> joint_names_;
-  std::chrono::nanoseconds future_wait_timeout_{0};
 
-  void publishGripperState();
+  /// reads every gripper state into gripper_state_ and publishes the joint states at most every
+  /// state_publish_period_, until stop_gripper_state_thread_ is set
+  void readGripperState();
 
   /// stops the gripper and writes the result into the response
   /// @param[out] response  will be updated with the success status and error message
@@ -117,7 +126,7 @@ class GripperActionServer : public rclcpp::Node {
   /// accepts any cancel request
   rclcpp_action::CancelResponse handleCancel(Task task);
 
-  /// accepts any goal request
+  /// accepts goal requests as long as the command queue has room for them
   rclcpp_action::GoalResponse handleGoal(Task task);
 
   /// performs homing
@@ -129,18 +138,17 @@ class GripperActionServer : public rclcpp::Node {
   /// performs grasp
   void executeGrasp(const std::shared_ptr<GoalHandleGrasp>& goal_handle);
 
-  /// Performs the moveit grasp command
-  /// @param goal_handle
-  /// @param command_handler eiter a grasp or move command defined by the onExecuteGripperCommand
-  /// method
-  void executeGripperCommand(const std::shared_ptr<GoalHandleGripperCommand>& goal_handle,
-                             const std::function<bool()>& command_handler);
+  /// Performs the moveit grasp command, either grasping or moving the gripper depending on the
+  /// gripper state when the command is executed
+  /// @param goal the commanded goal
+  /// @return the result without finishing the goal
+  std::shared_ptr<GripperCommand::Result> executeGripperCommand(
+      const GripperCommand::Goal& goal);
 
-  /// Defines a function for either grasping or moving the gripper, depending on the current gripper
-  /// state and the commanded goal. Then it calls executeGripperCommand to execute that function
+  /// Queues a job that executes the GripperCommand goal with executeGripperCommand
   void onExecuteGripperCommand(const std::shared_ptr<GoalHandleGripperCommand>& goal_handle);
 
-  /// Executes a gripper command
+  /// Queues a gripper command on the command executor
   /// @tparam T A gripper action message type (Move, Grasp, Homing)
   /// @param[in] goal_handle The goal handle from the action server
   /// @param[in] task The type of the Task
@@ -150,33 +158,50 @@ class GripperActionServer : public rclcpp::Node {
   void executeCommand(const std::shared_ptr<rclcpp_action::ServerGoalHandle<T>>& goal_handle,
                       Task task,
                       const std::function<bool()>& command_handler) {
-    const auto kTaskName = getTaskName(task);
-    RCLCPP_INFO(this->get_logger(), "Gripper %s...", kTaskName.c_str());
-
-    auto command_execution_thread = withResultGenerator<T>(command_handler);
-
-    std::future<std::shared_ptr<typename T::Result>> result_future =
-        std::async(std::launch::async, command_execution_thread);
-
-    while (not resultIsReady(result_future, future_wait_timeout_) and rclcpp::ok()) {
-      if (goal_handle->is_canceling()) {
-        gripper_->stop();
-        auto result = result_future.get();
-        RCLCPP_INFO(get_logger(), "Gripper %s canceled", kTaskName.c_str());
-        goal_handle->canceled(result);
-        return;
-      }
-      publishGripperWidthFeedback(goal_handle);
-    }
-    if (rclcpp::ok()) {
-      const auto kResult = result_future.get();
-      if (kResult->success) {
-        RCLCPP_INFO(get_logger(), "Gripper %s succeeded", kTaskName.c_str());
-        goal_handle->succeed(kResult);
-      } else {
-        RCLCPP_INFO(get_logger(), "Gripper %s failed", kTaskName.c_str());
-        goal_handle->abort(kResult);
+    auto result = std::make_shared<typename T::Result>();
+    GripperJob job;
+    job.execute = [task, command_handler, result, this]() {
+      RCLCPP_INFO(this->get_logger(), "Gripper %s...", getTaskName(task).c_str());
+      *result = *withResultGenerator<T>(command_handler)();
+    };
+    job.publish_feedback = [goal_handle, this]() { publishGripperWidthFeedback(goal_handle); };
+    job.is_canceling = [goal_handle]() { return goal_handle->is_canceling(); };
+    job.finish = [goal_handle, task, result, this](const std::string& abort_reason) {
+      if (not abort_reason.empty()) {
+        result->success = false;
+        result->error = abort_reason;
       }
+      finishGoal(goal_handle, task, result, result->success, abort_reason);
+    };
+    command_executor_->submit(std::move(job));
+  }
+
+  /// Ends a goal according to the result of its command
+  /// @tparam T A gripper action message type (Move, Grasp, Homing, GripperCommand)
+  /// @param[in] goal_handle The goal handle from the action server
+  /// @param[in] task The type of the Task
+  /// @param[in] result the result that is sent to the client
+  /// @param[in] succeeded whether the command reached its goal
+  /// @param[in] abort_reason why the goal was aborted by the executor, empty otherwise
+  template <typename T>
+  void finishGoal(const std::shared_ptr<rclcpp_action::ServerGoalHandle<T>>& goal_handle,
+                  Task task,
+                  const std::shared_ptr<typename T::Result>& result,
+                  bool succeeded,
+                  const std::string& abort_reason) {
+    const auto kTaskName = getTaskName(task);
+    if (goal_handle->is_canceling()) {
+      RCLCPP_INFO(get_logger(), "Gripper %s canceled", kTaskName.c_str());
+      goal_handle->canceled(result);
+    } else if (not abort_reason.empty()) {
+      RCLCPP_INFO(get_logger(), "Gripper %s aborted, %s", kTaskName.c_str(), abort_reason.c_str());
+      goal_handle->abort(result);
+    } else if (succeeded) {
+      RCLCPP_INFO(get_logger(), "Gripper %s succeeded", kTaskName.c_str());
+      goal_handle->succeed(result);
+    } else {
+      RCLCPP_INFO(get_logger(), "Gripper %s failed", kTaskName.c_str());
+      goal_handle->abort(result);
     }
   }
 
@@ -209,8 +234,7 @@ class GripperActionServer : public rclcpp::Node {
   void publishGripperWidthFeedback(
       const std::shared_ptr<rclcpp_action::ServerGoalHandle<T>>& goal_handle) {
     auto gripper_feedback = std::make_shared<typename T::Feedback>();
-    std::lock_guard<std::mutex> guard(gripper_state_mutex_);
-    gripper_feedback->current_width = current_gripper_state_.width;
+    gripper_feedback->current_width = gripper_state_.load().width;
     goal_handle->publish_feedback(gripper_feedback);
   }
 
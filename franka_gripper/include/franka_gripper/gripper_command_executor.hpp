@@ -0,0 +1,89 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace franka_gripper {
+
+/// The goal of one of the gripper action servers, as seen by the GripperCommandExecutor
+struct GripperJob {
+  /// sends the command to the gripper and blocks until the gripper is done
+  std::function<void()> execute;
+  /// publishes the action feedback while the job is executed
+  std::function<void()> publish_feedback;
+  /// @return whether the client requested to cancel the goal
+  std::function<bool()> is_canceling;
+  /// ends the goal. Called exactly once, after execute() returned or instead of it
+  /// @param abort_reason empty if the job ran to completion or was canceled, otherwise the reason
+  /// why it was aborted
+  std::function<void(const std::string& abort_reason)> finish;
+};
+
+/// Executes the gripper jobs of all action servers one after another on a single thread.
+///
+/// The gripper can only execute one command at a time, so the jobs of all action servers are
+/// arbitrated by one queue. With preemption a new job aborts the waiting ones and interrupts the
+/// active one, otherwise it waits for its turn as long as the queue is not full.
+class GripperCommandExecutor {
+ public:
+  /// @param queue_size how many jobs can wait while another one is executed, if not preempting
+  /// @param preempt whether a new job replaces the waiting ones and interrupts the active one
+  /// @param stop interrupts the active gripper command, must not throw
+  GripperCommandExecutor(size_t queue_size, bool preempt, std::function<void()> stop);
+
+  /// aborts the waiting jobs, interrupts the active one and joins the executor thread
+  ~GripperCommandExecutor();
+
+  GripperCommandExecutor(const GripperCommandExecutor&) = delete;
+  GripperCommandExecutor& operator=(const GripperCommandExecutor&) = delete;
+
+  /// @return whether a job submitted now would be queued
+  bool canAccept() const;
+
+  /// Queues a job. If the queue is full the job is aborted right away
+  /// @param job the job to execute
+  /// @return whether the job was queued
+  bool submit(GripperJob job);
+
+  /// Publishes the feedback of the active job, interrupts it if it is canceling and ends the
+  /// waiting jobs that are canceling. Should be called at the feedback rate.
+  void monitor();
+
+ private:
+  void run();
+
+  const size_t queue_size_;
+  const bool preempt_;
+  const std::function<void()> stop_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable job_available_;
+  std::deque<GripperJob> pending_jobs_;
+  GripperJob active_job_;
+  bool active_ = false;
+  bool active_stopped_ = false;
+  std::string active_abort_reason_;
+  bool shutdown_ = false;
+  std::thread thread_;
+};
+
+}  // namespace franka_gripper
@@ -0,0 +1,78 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace franka_gripper {
+
+/**
+ * Latest value of type T, written by one thread and read by any number of threads without locks.
+ *
+ * The writer never waits. A reader retries if the writer stored a new value while it was copying,
+ * which only happens if it is preempted for longer than the time between two stores.
+ * @tparam T a trivially copyable, default constructible type
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+ public:
+  /// Publishes value. Must only be called from one thread at a time.
+  void store(const T& value) {
+    std::array<uint64_t, kWords> words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    const uint64_t kSequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(kSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+      data_.at(i).store(words.at(i), std::memory_order_relaxed);
+    }
+    sequence_.store(kSequence + 2, std::memory_order_release);
+  }
+
+  /// @return the last stored value, or a value initialized T if nothing was stored yet.
+  T load() const {
+    std::array<uint64_t, kWords> words{};
+    uint64_t before = 0;
+    uint64_t after = 0;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < kWords; i++) {
+        words.at(i) = data_.at(i).load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while (before != after or (before & 1U) != 0);
+    T value{};
+    std::memcpy(&value, words.data(), sizeof(T));
+    return value;
+  }
+
+  /// @return how many values were stored so far.
+  uint64_t count() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> sequence_{0};
+  std::array<std::atomic<uint64_t>, kWords> data_{};
+};
+
+}  // namespace franka_gripper
@@ -12,8 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
-#include <future>
 #include <memory>
 #include <string>
 #include <thread>
@@ -40,6 +41,8 @@ GripperActionServer::GripperActionServer(const rclcpp::NodeOptions& options)
   this->declare_parameter("joint_names");
   this->declare_parameter("state_publish_rate", k_default_state_publish_rate);
   this->declare_parameter("feedback_publish_rate", k_default_feedback_publish_rate);
+  this->declare_parameter("command_queue_size", k_default_command_queue_size);
+  this->declare_parameter("preempt_active_goal", true);
   std::string robot_ip;
   if (not this->get_parameter<std::string>("robot_ip", robot_ip)) {
     RCLCPP_FATAL(this->get_logger(), "Parameter 'robot_ip' not set");
@@ -65,7 +68,17 @@ GripperActionServer::GripperActionServer(const rclcpp::NodeOptions& options)
       static_cast<double>(this->get_parameter("state_publish_rate").as_int());
   const double kFeedbackPublishRate =
       static_cast<double>(this->get_parameter("feedback_publish_rate").as_int());
-  this->future_wait_timeout_ = rclcpp::WallRate(kFeedbackPublishRate).period();
+  const auto kCommandQueueSize = this->get_parameter("command_queue_size").as_int();
+  if (kCommandQueueSize < 1) {
+    RCLCPP_FATAL(this->get_logger(), "Parameter 'command_queue_size' has to be positive, got %ld",
+                 kCommandQueueSize);
+    throw std::invalid_argument("Parameter 'command_queue_size' has to be positive");
+  }
+  const bool kPreemptActiveGoal = this->get_parameter("preempt_active_goal").as_bool();
+  // 0 publishes every state received from the gripper
+  if (kStatePublishRate > 0) {
+    this->state_publish_period_ = rclcpp::WallRate(kStatePublishRate).period();
+  }
 
   RCLCPP_INFO(this->get_logger(), "Trying to establish a connection with the gripper");
   try {
@@ -75,7 +88,19 @@ GripperActionServer::GripperActionServer(const rclcpp::NodeOptions& options)
     throw exception;
   }
   RCLCPP_INFO(this->get_logger(), "Connected to gripper");
-  current_gripper_state_ = gripper_->readOnce();
+  const auto kInitialState = gripper_->readOnce();
+  gripper_state_.store({kInitialState.width, kInitialState.max_width, kInitialState.is_grasped,
+                        kInitialState.temperature});
+  this->command_executor_ = std::make_unique<GripperCommandExecutor>(
+      static_cast<size_t>(kCommandQueueSize), kPreemptActiveGoal, [this]() {
+        try {
+          gripper_->stop();
+        } catch (const franka::Exception& e) {
+          RCLCPP_ERROR(this->get_logger(), e.what());
+        }
+      });
+  this->feedback_timer_ = this->create_wall_timer(rclcpp::WallRate(kFeedbackPublishRate).period(),
+                                                  [this]() { command_executor_->monitor(); });
   const auto kHomingTask = Task::kHoming;
   this->stop_service_ =  // NOLINTNEXTLINE
       create_service<Trigger>("~/stop",
@@ -87,39 +112,37 @@ GripperActionServer::GripperActionServer(const rclcpp::NodeOptions& options)
   this->homing_server_ = rclcpp_action::create_server<Homing>(
       this, "~/homing", [this](auto /*uuid*/, auto /*goal*/) { return handleGoal(kHomingTask); },
       [this](const auto& /*goal_handle*/) { return handleCancel(kHomingTask); },
-      [this](const auto& goal_handle) {
-        return std::thread{[goal_handle, this]() { executeHoming(goal_handle); }}.detach();
-      });
+      [this](const auto& goal_handle) { executeHoming(goal_handle); });
   const auto kMoveTask = Task::kMove;
   this->move_server_ = rclcpp_action::create_server<Move>(
       this, "~/move", [this](auto /*uuid*/, auto /*goal*/) { return handleGoal(kMoveTask); },
       [this](const auto& /*goal_handle*/) { return handleCancel(kMoveTask); },
-      [this](const auto& goal_handle) {
-        return std::thread{[goal_handle, this]() { executeMove(goal_handle); }}.detach();
-      });
+      [this](const auto& goal_handle) { executeMove(goal_handle); });
 
   const auto kGraspTask = Task::kGrasp;
   this->grasp_server_ = rclcpp_action::create_server<Grasp>(
       this, "~/grasp", [this](auto /*uuid*/, auto /*goal*/) { return handleGoal(kGraspTask); },
       [this](const auto& /*goal_handle*/) { return handleCancel(kGraspTask); },
-      [this](const auto& goal_handle) {
-        return std::thread{[goal_handle, this]() { executeGrasp(goal_handle); }}.detach();
-      });
+      [this](const auto& goal_handle) { executeGrasp(goal_handle); });
 
   const auto kGripperCommandTask = Task::kGripperCommand;
   this->gripper_command_server_ = rclcpp_action::create_server<GripperCommand>(
       this, "~/gripper_action",
       [this](auto /*uuid*/, auto /*goal*/) { return handleGoal(kGripperCommandTask); },
       [this](const auto& /*goal_handle*/) { return handleCancel(kGripperCommandTask); },
-      [this](const auto& goal_handle) {
-        return std::thread{[goal_handle, this]() { onExecuteGripperCommand(goal_handle); }}
-            .detach();
-      });
+      [this](const auto& goal_handle) { onExecuteGripperCommand(goal_handle); });
 
   this->joint_states_publisher_ =
       this->create_publisher<sensor_msgs::msg::JointState>("~/joint_states", 1);
-  this->timer_ = this->create_wall_timer(rclcpp::WallRate(kStatePublishRate).period(),
-                                         [this]() { return publishGripperState(); });
+  this->gripper_state_thread_ = std::thread([this]() { readGripperState(); });
+}
+
+GripperActionServer::~GripperActionServer() {
+  stop_gripper_state_thread_ = true;
+  // readOnce() returns with the next state the gripper sends
+  if (gripper_state_thread_.joinable()) {
+    gripper_state_thread_.join();
+  }
 }
 
 rclcpp_action::CancelResponse GripperActionServer::handleCancel(Task task) {
@@ -129,6 +152,11 @@ rclcpp_action::CancelResponse GripperActionServer::handleCancel(Task task) {
 
 rclcpp_action::GoalResponse GripperActionServer::handleGoal(Task task) {
   RCLCPP_INFO(this->get_logger(), "Received %s request", getTaskName(task).c_str());
+  if (not command_executor_->canAccept()) {
+    RCLCPP_ERROR(this->get_logger(), "Rejected %s request, the gripper command queue is full",
+                 getTaskName(task).c_str());
+    return rclcpp_action::GoalResponse::REJECT;
+  }
   return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
 }
 
@@ -156,83 +184,59 @@ void GripperActionServer::executeGrasp(const std::shared_ptr<GoalHandleGrasp>& g
 
 void GripperActionServer::onExecuteGripperCommand(
     const std::shared_ptr<GoalHandleGripperCommand>& goal_handle) {
-  const auto kGoal = goal_handle->get_goal();
-  const double kTargetWidth = 2 * kGoal->command.position;
+  auto result = std::make_shared<GripperCommand::Result>();
+  GripperJob job;
+  job.execute = [goal_handle, result, this]() {
+    *result = *executeGripperCommand(*goal_handle->get_goal());
+  };
+  job.publish_feedback = [goal_handle, this]() { publishGripperCommandFeedback(goal_handle); };
+  job.is_canceling = [goal_handle]() { return goal_handle->is_canceling(); };
+  job.finish = [goal_handle, result, this](const std::string& abort_reason) {
+    finishGoal(goal_handle, Task::kGripperCommand, result,
+               result->reached_goal and abort_reason.empty(), abort_reason);
+  };
+  command_executor_->submit(std::move(job));
+}
+
+std::shared_ptr<GripperActionServer::GripperCommand::Result>
+GripperActionServer::executeGripperCommand(const GripperCommand::Goal& goal) {
+  const double kTargetWidth = 2 * goal.command.position;
 
-  std::unique_lock<std::mutex> guard(gripper_state_mutex_);
+  const auto kGripperState = gripper_state_.load();
   constexpr double kSamePositionThreshold = 1e-4;
   auto result = std::make_shared<control_msgs::action::GripperCommand::Result>();
-  const double kCurrentWidth = current_gripper_state_.width;
-  if (kTargetWidth > current_gripper_state_.max_width or kTargetWidth < 0) {
+  const double kCurrentWidth = kGripperState.width;
+  if (kTargetWidth > kGripperState.max_width or kTargetWidth < 0) {
     RCLCPP_ERROR(this->get_logger(),
                  "GripperServer: Commanding out of range width! max_width = %f command = %f",
-                 current_gripper_state_.max_width, kTargetWidth);
-    goal_handle->abort(result);
-    return;
+                 kGripperState.max_width, kTargetWidth);
+    return result;
   }
   if (std::abs(kTargetWidth - kCurrentWidth) < kSamePositionThreshold) {
     result->effort = 0;
     result->position = kCurrentWidth;
     result->reached_goal = true;
     result->stalled = false;
-    goal_handle->succeed(result);
-    return;
+    return result;
   }
-  guard.unlock();
-  auto command = [kTargetWidth, kCurrentWidth, kGoal, this]() {
-    if (kTargetWidth >= kCurrentWidth) {
-      return gripper_->move(kTargetWidth, default_speed_);
-    }
-    return gripper_->grasp(kTargetWidth, default_speed_, kGoal->command.max_effort,
-                           default_epsilon_inner_, default_epsilon_outer_);
-  };
 
-  executeGripperCommand(goal_handle, command);
-}
-
-void GripperActionServer::executeGripperCommand(
-    const std::shared_ptr<GoalHandleGripperCommand>& goal_handle,
-    const std::function<bool()>& command_handler) {
   const auto kTaskName = getTaskName(Task::kGripperCommand);
   RCLCPP_INFO(this->get_logger(), "Gripper %s...", kTaskName.c_str());
-
-  auto command_execution_thread = [command_handler, this]() {
-    auto result = std::make_shared<GripperCommand::Result>();
-    try {
-      result->reached_goal = command_handler();
-    } catch (const franka::Exception& e) {
-      result->reached_goal = false;
-      RCLCPP_ERROR(this->get_logger(), e.what());
-    }
-    return result;
-  };
-
-  std::future<std::shared_ptr<typename GripperCommand ::Result>> result_future =
-      std::async(std::launch::async, command_execution_thread);
-
-  while (not resultIsReady(result_future, future_wait_timeout_) and rclcpp::ok()) {
-    if (goal_handle->is_canceling()) {
-      gripper_->stop();
-      auto result = result_future.get();
-      RCLCPP_INFO(get_logger(), "Gripper %s canceled", kTaskName.c_str());
-      goal_handle->canceled(result);
-      return;
-    }
-    publishGripperCommandFeedback(goal_handle);
-  }
-  if (rclcpp::ok()) {
-    const auto kResult = result_future.get();
-    std::lock_guard<std::mutex> guard(gripper_state_mutex_);
-    kResult->position = current_gripper_state_.width;
-    kResult->effort = 0.;
-    if (kResult->reached_goal) {
-      RCLCPP_INFO(get_logger(), "Gripper %s succeeded", kTaskName.c_str());
-      goal_handle->succeed(kResult);
+  try {
+    if (kTargetWidth >= kCurrentWidth) {
+      result->reached_goal = gripper_->move(kTargetWidth, default_speed_);
     } else {
-      RCLCPP_INFO(get_logger(), "Gripper %s failed", kTaskName.c_str());
-      goal_handle->abort(kResult);
+      result->reached_goal =
+          gripper_->grasp(kTargetWidth, default_speed_, goal.command.max_effort,
+                          default_epsilon_inner_, default_epsilon_outer_);
     }
+  } catch (const franka::Exception& e) {
+    result->reached_goal = false;
+    RCLCPP_ERROR(this->get_logger(), e.what());
   }
+  result->position = gripper_state_.load().width;
+  result->effort = 0.;
+  return result;
 }
 
 void GripperActionServer::stopServiceCallback(const std::shared_ptr<Trigger::Response>& response) {
@@ -250,31 +254,40 @@ void GripperActionServer::stopServiceCallback(const std::shared_ptr<Trigger::Res
   }
 }
 
-void GripperActionServer::publishGripperState() {
-  std::lock_guard<std::mutex> lock(gripper_state_mutex_);
-  try {
-    current_gripper_state_ = gripper_->readOnce();
-  } catch (const franka::Exception& e) {
-    RCLCPP_ERROR(this->get_logger(), e.what());
-  }
+void GripperActionServer::readGripperState() {
   sensor_msgs::msg::JointState joint_states;
-  joint_states.header.stamp = this->now();
-  joint_states.name.push_back(this->joint_names_[0]);
-  joint_states.name.push_back(this->joint_names_[1]);
-  joint_states.position.push_back(current_gripper_state_.width / 2);
-  joint_states.position.push_back(current_gripper_state_.width / 2);
-  joint_states.velocity.push_back(0.0);
-  joint_states.velocity.push_back(0.0);
-  joint_states.effort.push_back(0.0);
-  joint_states.effort.push_back(0.0);
-  joint_states_publisher_->publish(joint_states);
+  joint_states.name = joint_names_;
+  joint_states.position.resize(2);
+  joint_states.velocity.assign(2, 0.0);
+  joint_states.effort.assign(2, 0.0);
+  auto next_publish_time = std::chrono::steady_clock::now();
+  while (not stop_gripper_state_thread_ and rclcpp::ok()) {
+    GripperStateSnapshot snapshot;
+    try {
+      const auto kState = gripper_->readOnce();
+      snapshot = {kState.width, kState.max_width, kState.is_grasped, kState.temperature};
+    } catch (const franka::Exception& e) {
+      RCLCPP_ERROR_THROTTLE(this->get_logger(), *this->get_clock(), 1000, "%s", e.what());
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+    gripper_state_.store(snapshot);
+
+    const auto kNow = std::chrono::steady_clock::now();
+    if (kNow < next_publish_time) {
+      continue;
+    }
+    next_publish_time = kNow + state_publish_period_;
+    joint_states.header.stamp = this->now();
+    std::fill(joint_states.position.begin(), joint_states.position.end(), snapshot.width / 2);
+    joint_states_publisher_->publish(joint_states);
+  }
 }
 
 void GripperActionServer::publishGripperCommandFeedback(
     const std::shared_ptr<rclcpp_action::ServerGoalHandle<GripperCommand>>& goal_handle) {
   auto gripper_feedback = std::make_shared<GripperCommand::Feedback>();
-  std::lock_guard<std::mutex> guard(gripper_state_mutex_);
-  gripper_feedback->position = current_gripper_state_.width;
+  gripper_feedback->position = gripper_state_.load().width;
   gripper_feedback->effort = 0.;
   goal_handle->publish_feedback(gripper_feedback);
 }
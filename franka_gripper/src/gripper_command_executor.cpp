@@ -0,0 +1,144 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_gripper/gripper_command_executor.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace {
+const std::string kQueueFull = "the gripper command queue is full";
+const std::string kPreempted = "preempted by a newer goal";
+const std::string kShutdown = "the gripper node is shutting down";
+}  // namespace
+
+namespace franka_gripper {
+
+GripperCommandExecutor::GripperCommandExecutor(size_t queue_size,
+                                               bool preempt,
+                                               std::function<void()> stop)
+    : queue_size_(queue_size), preempt_(preempt), stop_(std::move(stop)) {
+  thread_ = std::thread([this]() { run(); });
+}
+
+GripperCommandExecutor::~GripperCommandExecutor() {
+  std::deque<GripperJob> aborted_jobs;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    aborted_jobs.swap(pending_jobs_);
+    if (active_ and not active_stopped_) {
+      active_abort_reason_ = kShutdown;
+      active_stopped_ = true;
+      stop_();
+    }
+  }
+  job_available_.notify_one();
+  thread_.join();
+  for (const auto& job : aborted_jobs) {
+    job.finish(kShutdown);
+  }
+}
+
+bool GripperCommandExecutor::canAccept() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return not shutdown_ and (preempt_ or pending_jobs_.size() < queue_size_);
+}
+
+bool GripperCommandExecutor::submit(GripperJob job) {
+  std::deque<GripperJob> preempted_jobs;
+  std::string reject_reason;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shutdown_) {
+      reject_reason = kShutdown;
+    } else if (not preempt_ and pending_jobs_.size() >= queue_size_) {
+      reject_reason = kQueueFull;
+    } else {
+      if (preempt_) {
+        preempted_jobs.swap(pending_jobs_);
+        // stop under the lock, otherwise it could hit the next job once the active one returned
+        if (active_ and not active_stopped_) {
+          active_abort_reason_ = kPreempted;
+          active_stopped_ = true;
+          stop_();
+        }
+      }
+      pending_jobs_.push_back(std::move(job));
+    }
+  }
+  if (not reject_reason.empty()) {
+    job.finish(reject_reason);
+    return false;
+  }
+  job_available_.notify_one();
+  for (const auto& preempted_job : preempted_jobs) {
+    preempted_job.finish(kPreempted);
+  }
+  return true;
+}
+
+void GripperCommandExecutor::monitor() {
+  std::deque<GripperJob> canceled_jobs;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto canceling = std::stable_partition(
+        pending_jobs_.begin(), pending_jobs_.end(),
+        [](const GripperJob& job) { return not job.is_canceling(); });
+    std::move(canceling, pending_jobs_.end(), std::back_inserter(canceled_jobs));
+    pending_jobs_.erase(canceling, pending_jobs_.end());
+
+    if (active_ and not active_stopped_) {
+      if (active_job_.is_canceling()) {
+        active_stopped_ = true;
+        stop_();
+      } else {
+        active_job_.publish_feedback();
+      }
+    }
+  }
+  for (const auto& job : canceled_jobs) {
+    job.finish("");
+  }
+}
+
+void GripperCommandExecutor::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    job_available_.wait(lock, [this]() { return shutdown_ or not pending_jobs_.empty(); });
+    if (shutdown_) {
+      return;
+    }
+    active_job_ = std::move(pending_jobs_.front());
+    pending_jobs_.pop_front();
+    active_ = true;
+    active_stopped_ = false;
+    active_abort_reason_.clear();
+    lock.unlock();
+
+    if (not active_job_.is_canceling()) {
+      active_job_.execute();
+    }
+
+    lock.lock();
+    active_ = false;
+    const std::string kAbortReason = active_abort_reason_;
+    lock.unlock();
+    active_job_.finish(kAbortReason);
+    lock.lock();
+  }
+}
+
+}  // namespace franka_gripper
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <franka_hardware/robot.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+namespace franka_hardware {
+
+/**
+ * Periodically publishes the timing statistics of a Robot on /diagnostics.
+ *
+ * The publisher runs its own node and executor in a separate thread, so it never interferes with
+ * the controller_manager loop or the libfranka control loop.
+ */
+class DiagnosticsPublisher {
+ public:
+  /**
+   * Starts publishing.
+   * @param[in] robot the robot to report about. Must outlive this object.
+   * @param[in] name name of the diagnostic status and prefix of the node name.
+   * @param[in] period time between two messages.
+   */
+  DiagnosticsPublisher(Robot* robot, const std::string& name, std::chrono::nanoseconds period);
+  DiagnosticsPublisher(const DiagnosticsPublisher&) = delete;
+  DiagnosticsPublisher& operator=(const DiagnosticsPublisher&) = delete;
+  DiagnosticsPublisher(DiagnosticsPublisher&&) = delete;
+  DiagnosticsPublisher& operator=(DiagnosticsPublisher&&) = delete;
+
+  /// Stops publishing and joins the publisher thread.
+  ~DiagnosticsPublisher();
+
+ private:
+  void publish();
+
+  Robot* robot_;
+  std::string name_;
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr publisher_;
+  rclcpp::TimerBase::SharedPtr timer_;
+  rclcpp::executors::SingleThreadedExecutor executor_;
+  std::atomic_bool finish_{false};
+  std::thread thread_;
+};
+
+}  // namespace franka_hardware
@@ -0,0 +1,116 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <franka/robot_state.h>
+#include <rclcpp/logger.hpp>
+
+namespace franka_hardware {
+
+/**
+ * Ring buffer of the last robot states and torque commands of the control loop, which can be
+ * dumped to a file, e.g. after a reflex.
+ *
+ * record() is called from the control loop. It only copies into memory allocated by the
+ * constructor and never blocks. dump() hands the buffer to a writer thread, which copies it into a
+ * memory-mapped file while recording goes on. Records which are overwritten during the copy are
+ * dropped from the file.
+ *
+ * File format, little endian:
+ * - header: char[8] "FRANKAFR", uint32 version, uint32 number of columns C, uint64 number of
+ *   records R, uint64 text size T
+ * - T bytes of text: the comma-separated column names, a newline and the reason of the dump,
+ *   padded with zeros to a multiple of 8 bytes
+ * - R records, oldest first, of C doubles each
+ *
+ * scripts/flight_recorder_convert.py converts the file to CSV or MCAP.
+ */
+class FlightRecorder {
+ public:
+  /// Version of the file format.
+  static constexpr uint32_t kFileVersion = 1;
+
+  /**
+   * Allocates and touches the buffer and starts the writer thread.
+   * @param[in] capacity number of records kept, i.e. milliseconds of history.
+   * @param[in] file_prefix path and name prefix of the files, the time and ".frec" are appended.
+   * @param[in] logger ROS Logger to report failed dumps.
+   */
+  FlightRecorder(size_t capacity, std::string file_prefix, const rclcpp::Logger& logger);
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+  FlightRecorder(FlightRecorder&&) = delete;
+  FlightRecorder& operator=(FlightRecorder&&) = delete;
+
+  /// Finishes a pending dump and joins the writer thread.
+  ~FlightRecorder();
+
+  /// @return the names of the columns of a record, in file order.
+  static std::vector<std::string> columns();
+
+  /**
+   * Appends one record, overwriting the oldest one if the buffer is full. Wait-free and does not
+   * allocate. Must only be called from one thread.
+   * @param[in] state the robot state of this tick.
+   * @param[in] tau_command the commanded torques, NaN if the loop does not command torques.
+   */
+  void record(const franka::RobotState& state, const std::array<double, 7>& tau_command);
+
+  /**
+   * Writes the recorded history to a new file in the writer thread. Not real-time safe.
+   * @param[in] reason why the dump was made, stored in the file.
+   * @param[out] path the file which is going to be written.
+   * @return false if the previous dump is still pending.
+   */
+  bool dump(const std::string& reason, std::string* path);
+
+ private:
+  /// body of the writer thread.
+  void runWriter();
+
+  /// copies the history into a memory-mapped file at path.
+  void writeFile(const std::string& path, const std::string& reason);
+
+  const size_t capacity_;
+  const size_t record_size_;
+  const std::string file_prefix_;
+  rclcpp::Logger logger_;
+
+  std::vector<double> records_;
+  // records which were started and finished by record(), both only increase
+  std::atomic<uint64_t> started_{0};
+  std::atomic<uint64_t> finished_{0};
+
+  std::mutex mutex_;
+  std::condition_variable dump_requested_;
+  bool dump_pending_ = false;
+  bool shutdown_ = false;
+  std::string pending_path_;
+  std::string pending_reason_;
+  unsigned dump_count_ = 0;
+  std::thread writer_thread_;
+};
+
+}  // namespace franka_hardware
@@ -0,0 +1,59 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <franka_hardware/flight_recorder.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <std_srvs/srv/trigger.hpp>
+
+namespace franka_hardware {
+
+/**
+ * Offers a ~/dump Trigger service which dumps a FlightRecorder. The response message is the path
+ * of the file.
+ *
+ * Like the DiagnosticsPublisher, the service runs its own node and executor in a separate thread.
+ */
+class FlightRecorderService {
+ public:
+  /**
+   * Starts the service.
+   * @param[in] recorder the recorder to dump. Must outlive this object.
+   * @param[in] name prefix of the node name.
+   */
+  FlightRecorderService(FlightRecorder* recorder, const std::string& name);
+  FlightRecorderService(const FlightRecorderService&) = delete;
+  FlightRecorderService& operator=(const FlightRecorderService&) = delete;
+  FlightRecorderService(FlightRecorderService&&) = delete;
+  FlightRecorderService& operator=(FlightRecorderService&&) = delete;
+
+  /// Stops the service and joins its thread.
+  ~FlightRecorderService();
+
+ private:
+  FlightRecorder* recorder_;
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr service_;
+  rclcpp::executors::SingleThreadedExecutor executor_;
+  std::atomic_bool finish_{false};
+  std::thread thread_;
+};
+
+}  // namespace franka_hardware
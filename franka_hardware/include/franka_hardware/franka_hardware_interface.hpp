@@ -14,12 +14,19 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <hardware_interface/visibility_control.h>
+#include <franka_hardware/diagnostics_publisher.hpp>
+#include <franka_hardware/flight_recorder_service.hpp>
+#include <franka_hardware/gripper.hpp>
 #include <franka_hardware/robot.hpp>
+#include <franka_hardware/shared_state_writer.hpp>
 #include <hardware_interface/hardware_info.hpp>
 #include <hardware_interface/system_interface.hpp>
 #include <hardware_interface/types/hardware_interface_return_values.hpp>
@@ -32,6 +39,11 @@ using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface
 
 namespace franka_hardware {
 
+/**
+ * ros2_control system of one or more arms. Every arm has its own Robot with its own control thread,
+ * the joints of the arms are listed one arm after the other in the same order as the 'robot_ip'
+ * and 'arm_id' parameters.
+ */
 class FrankaHardwareInterface : public hardware_interface::SystemInterface {
  public:
   hardware_interface::return_type prepare_command_mode_switch(
@@ -47,16 +59,107 @@ class FrankaHardwareInterface : public hardware_interface::SystemInterface {
   hardware_interface::return_type read() override;
   hardware_interface::return_type write() override;
   CallbackReturn on_init(const hardware_interface::HardwareInfo& info) override;
+  /// joints per arm
   static const size_t kNumberOfJoints = 7;
 
  private:
-  std::unique_ptr<Robot> robot_;
-  std::array<double, kNumberOfJoints> hw_commands_{0, 0, 0, 0, 0, 0, 0};
-  std::array<double, kNumberOfJoints> hw_positions_{0, 0, 0, 0, 0, 0, 0};
-  std::array<double, kNumberOfJoints> hw_velocities_{0, 0, 0, 0, 0, 0, 0};
-  std::array<double, kNumberOfJoints> hw_efforts_{0, 0, 0, 0, 0, 0, 0};
-  bool effort_interface_claimed_ = false;
-  bool effort_interface_running_ = false;
+  /// The sets of command interfaces which can be claimed. Only one of them can be active at a time.
+  enum class ControlMode : size_t {
+    kNone,
+    kEffort,
+    kJointPosition,
+    kJointVelocity,
+    kCartesianVelocity,
+  };
+  static constexpr size_t kNumberOfControlModes = 5;
+  static constexpr size_t kCartesianDimensions = 6;
+
+  /// The connection, state and commands of one arm. The exported interfaces point into it.
+  struct Arm {
+    std::string id;
+    std::unique_ptr<Robot> robot;
+    // declared after robot, so they are destroyed first
+    std::unique_ptr<DiagnosticsPublisher> diagnostics_publisher;
+    // only offered if the 'flight_recorder_duration' parameter is set
+    std::unique_ptr<FlightRecorderService> flight_recorder_service;
+    // only exported if the 'shared_state' parameter is set
+    std::unique_ptr<SharedStateWriter> shared_state_writer;
+    // only connected if the 'gripper' parameter is set
+    std::unique_ptr<Gripper> gripper;
+    const franka::Model* model = nullptr;
+
+    ControlMode claimed_mode = ControlMode::kNone;
+    ControlMode running_mode = ControlMode::kNone;
+
+    std::array<double, kNumberOfJoints> hw_effort_commands{0, 0, 0, 0, 0, 0, 0};
+    std::array<double, kNumberOfJoints> hw_position_commands{0, 0, 0, 0, 0, 0, 0};
+    std::array<double, kNumberOfJoints> hw_velocity_commands{0, 0, 0, 0, 0, 0, 0};
+    std::array<double, kCartesianDimensions> hw_cartesian_velocity_commands{0, 0, 0, 0, 0, 0};
+    std::array<double, kNumberOfJoints> hw_positions{0, 0, 0, 0, 0, 0, 0};
+    std::array<double, kNumberOfJoints> hw_velocities{0, 0, 0, 0, 0, 0, 0};
+    std::array<double, kNumberOfJoints> hw_efforts{0, 0, 0, 0, 0, 0, 0};
+
+    // optional state interfaces, selected by the 'extended_state_interfaces' parameter
+    std::array<double, 16> hw_o_t_ee{};
+    std::array<double, 6> hw_o_f_ext_hat_k{};
+    std::array<double, 6> hw_k_f_ext_hat_k{};
+    std::array<double, kNumberOfJoints> hw_tau_ext_hat_filtered{};
+    std::array<double, kNumberOfJoints> hw_gravity{};
+    std::array<double, kNumberOfJoints> hw_coriolis{};
+    std::array<double, kNumberOfJoints * kNumberOfJoints> hw_mass{};
+
+    // gripper interfaces, exported if the gripper is connected
+    double hw_finger_position = 0;
+    double hw_finger_velocity = 0;
+    double hw_gripper_is_grasped = 0;
+    double hw_gripper_width_command = std::numeric_limits<double>::quiet_NaN();
+    double hw_gripper_force_command = 0;
+  };
+
+  /// @param[in] interface full name of a command interface.
+  /// @param[out] arm index of the arm the interface belongs to, only set if it is one of ours.
+  /// @return the control mode an interface of this hardware belongs to or kNone if the interface
+  /// is not one of our command interfaces.
+  ControlMode getControlMode(const std::string& interface, size_t* arm) const;
+
+  /// @return the number of command interfaces of one arm which have to be claimed together for a
+  /// mode.
+  static size_t getNumberOfInterfaces(ControlMode mode);
+
+  static const char* toString(ControlMode mode);
+
+  /// Parses the '<prefix>_priority' and '<prefix>_cpus' hardware parameters. Settings which are
+  /// not given are left untouched.
+  /// @return false if a parameter is set but invalid.
+  bool parseThreadSettings(const std::string& prefix, ThreadSettings* settings) const;
+
+  /// Parses the 'extended_state_interfaces' hardware parameter.
+  /// @return false if the parameter contains an unknown interface.
+  bool parseExtendedStateInterfaces(const std::string& interfaces);
+
+  /// @return the 'initial_position' parameters of the joints of an arm, 0 if not given.
+  std::array<double, kNumberOfJoints> getInitialPositions(size_t arm) const;
+
+  /// Copies the latest state of an arm into its state interfaces.
+  /// @return false if the control loop of the arm aborted with an error.
+  bool readArm(Arm* arm);
+
+  std::vector<std::unique_ptr<Arm>> arms_;
+  // how long read() waits for a new state of every arm, only used with more than one arm
+  std::chrono::nanoseconds arm_sync_timeout_{0};
+  // applied to the controller_manager thread on the first call of read()
+  ThreadSettings controller_manager_thread_settings_;
+  bool controller_manager_thread_configured_ = false;
+  // reused, so reporting errors of the control thread does not allocate in most cases
+  std::string error_message_;
+  std::vector<std::string> joint_command_interfaces_;
+
+  // optional state interfaces, selected by the 'extended_state_interfaces' parameter
+  StateFieldMask state_fields_ = 0;
+  bool export_gravity_ = false;
+  bool export_coriolis_ = false;
+  bool export_mass_ = false;
+
   static rclcpp::Logger getLogger();
 };
 }  // namespace franka_hardware
\ No newline at end of file
@@ -0,0 +1,119 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <franka/gripper.h>
+#include <franka_hardware/triple_buffer.hpp>
+#include <rclcpp/logger.hpp>
+
+namespace franka_hardware {
+
+/**
+ * Franka Hand attached to the robot, used from the controller_manager thread without blocking it.
+ *
+ * A reader thread streams the gripper state into a TripleBuffer and a command thread executes the
+ * blocking libfranka gripper commands. A new command interrupts the running one, the interruption
+ * is sent by the reader thread with the next gripper state.
+ */
+class Gripper {
+ public:
+  /// The latest gripper state.
+  struct State {
+    /// distance between the fingers in m
+    double width = 0;
+    /// change of width in m/s
+    double width_velocity = 0;
+    /// whether an object is grasped
+    bool is_grasped = false;
+  };
+
+  /**
+   * Connects to the gripper and starts the reader and command threads. An exception will be
+   * thrown if the connection cannot be established.
+   *
+   * @param[in] robot_ip IP address or hostname of the robot the gripper is attached to.
+   * @param[in] logger ROS Logger to print errors of the gripper commands.
+   * @param[in] speed speed of the gripper commands in m/s.
+   */
+  Gripper(const std::string& robot_ip, const rclcpp::Logger& logger, double speed);
+  Gripper(const Gripper&) = delete;
+  Gripper& operator=(const Gripper& other) = delete;
+  Gripper& operator=(Gripper&& other) = delete;
+  Gripper(Gripper&& other) = delete;
+
+  /// Interrupts the running command and joins the threads.
+  virtual ~Gripper();
+
+  /**
+   * Get the current gripper state without blocking. Must only be called from one thread at a
+   * time.
+   * @return the latest gripper state. The reference stays valid until the next call.
+   */
+  const State& read();
+
+  /**
+   * Requests a gripper command without blocking. A command is only sent if it differs from the
+   * previous one, so it can be called with the same values every cycle. Must only be called from
+   * one thread at a time.
+   * @param[in] width target width in m. NaN does not send a command.
+   * @param[in] force grasping force in N. The gripper grasps if it is positive and moves otherwise.
+   */
+  void write(double width, double force);
+
+ private:
+  struct Command {
+    double width = 0;
+    double force = 0;
+  };
+
+  /// body of the reader thread. Reads the gripper state until shutdown_ is set.
+  void runReader();
+
+  /// body of the command thread. Executes the pending commands until shutdown_ is set.
+  void runCommands();
+
+  /// interrupts the running command once. Must be called with command_mutex_ locked.
+  void stopCommand();
+
+  rclcpp::Logger logger_;
+  const double speed_;
+  std::unique_ptr<franka::Gripper> gripper_;
+  // written by the reader thread, read by read()
+  TripleBuffer<State> current_state_;
+
+  // the pending command and the state of the command thread. write() only try-locks the mutex.
+  std::mutex command_mutex_;
+  std::condition_variable command_available_;
+  Command pending_command_;
+  bool command_pending_ = false;
+  bool command_running_ = false;
+  bool command_stopped_ = false;
+  std::atomic_bool shutdown_{false};
+
+  // the last command accepted by write(), only used by write()
+  Command last_command_{std::numeric_limits<double>::quiet_NaN(), 0};
+
+  std::thread reader_thread_;
+  std::thread command_thread_;
+};
+}  // namespace franka_hardware
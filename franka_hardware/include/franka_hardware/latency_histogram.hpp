@@ -0,0 +1,68 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace franka_hardware {
+
+/**
+ * Histogram of durations which is filled from a real-time thread and read from another thread.
+ *
+ * record() is wait-free apart from the maximum update and neither allocates nor blocks, so it can
+ * be called in the libfranka control callback. collect() summarizes everything recorded since its
+ * previous call and must only be called from a single non real-time thread.
+ */
+class LatencyHistogram {
+ public:
+  /// Width of one bucket. It bounds the resolution of the reported percentiles.
+  static constexpr int64_t kBucketWidthNs = 5'000;
+  /// Number of buckets. The last bucket collects all durations above 2 ms.
+  static constexpr size_t kNumberOfBuckets = 401;
+
+  /// Statistics of the durations recorded in one collection interval.
+  struct Summary {
+    uint64_t count = 0;
+    double mean_us = 0;
+    /// upper bound of the median
+    double p50_us = 0;
+    /// upper bound of the 99th percentile
+    double p99_us = 0;
+    double max_us = 0;
+  };
+
+  /**
+   * Adds one duration to the histogram. Negative durations are counted as zero.
+   * @param[in] duration_ns the duration in nanoseconds.
+   */
+  void record(int64_t duration_ns);
+
+  /// @return summary of all durations recorded since the previous call.
+  Summary collect();
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumberOfBuckets> buckets_{};
+  std::atomic<int64_t> sum_ns_{0};
+  std::atomic<int64_t> max_ns_{0};
+
+  // state of the reader from the previous collect() call
+  std::array<uint64_t, kNumberOfBuckets> collected_buckets_{};
+  int64_t collected_sum_ns_ = 0;
+};
+
+}  // namespace franka_hardware
@@ -0,0 +1,67 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+#include <franka_hardware/robot_backend.hpp>
+
+namespace franka_hardware {
+
+/**
+ * Backend without a robot, for testing and benchmarking the control stack.
+ *
+ * Generates a robot state every millisecond in the calling thread, like libfranka does. The joints
+ * are simulated as independent, damped unit inertias without gravity: torques are integrated,
+ * joint positions and velocities are followed exactly and Cartesian velocities are accepted but
+ * do not move the joints. There is no dynamics model.
+ */
+class MockRobotBackend : public RobotBackend {
+ public:
+  /// @param[in] initial_positions joint positions of the simulated robot at start.
+  explicit MockRobotBackend(const std::array<double, 7>& initial_positions);
+
+  void read(const std::function<bool(const franka::RobotState&)>& callback) override;
+  void control(const ControlCallback<franka::Torques>& callback) override;
+  void control(const ControlCallback<franka::JointPositions>& callback) override;
+  void control(const ControlCallback<franka::JointVelocities>& callback) override;
+  void control(const ControlCallback<franka::CartesianVelocities>& callback) override;
+
+  /// @throw franka::ModelException always, the mock has no dynamics model.
+  franka::Model loadModel() override;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Runs a control loop until a command has motion_finished set.
+   * @param[in] callback the libfranka callback.
+   * @param[in] apply advances state_ by one cycle with the returned command.
+   */
+  template <typename Command>
+  void runControl(const ControlCallback<Command>& callback,
+                  const std::function<void(const Command&)>& apply);
+
+  /// sleeps until the next cycle and advances the time of state_.
+  void waitForNextCycle();
+
+  franka::RobotState state_;
+  Clock::time_point next_cycle_;
+  bool first_cycle_ = true;
+};
+
+}  // namespace franka_hardware
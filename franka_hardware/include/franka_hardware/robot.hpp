@@ -16,27 +16,63 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <thread>
 
+#include <franka/model.h>
 #include <franka/robot.h>
+#include <franka_hardware/flight_recorder.hpp>
+#include <franka_hardware/latency_histogram.hpp>
+#include <franka_hardware/robot_backend.hpp>
+#include <franka_hardware/robot_state_snapshot.hpp>
+#include <franka_hardware/thread_settings.hpp>
+#include <franka_hardware/triple_buffer.hpp>
 #include <rclcpp/logger.hpp>
 
 namespace franka_hardware {
 
 class Robot {
  public:
+  /// Timing of the libfranka callback since the previous call to collectStatistics().
+  struct Statistics {
+    /// time spent in the callback until the command is handed back to libfranka
+    LatencyHistogram::Summary callback_duration;
+    /// time between the last call of a write method and the use of its command in the callback
+    LatencyHistogram::Summary command_age;
+    /// time between two consecutive robot states
+    LatencyHistogram::Summary state_interval;
+    /// lowest control_command_success_rate reported by the robot
+    double min_success_rate = 1;
+  };
+
   /**
    * Connects to the robot. This method can block for up to one minute if the robot is not
    * responding. An exception will be thrown if the connection cannot be established.
    *
    * @param[in] robot_ip IP address or hostname of the robot.
    * @param[im] logger ROS Logger to print eventual warnings.
+   * @param[in] control_thread_settings scheduling of the thread running the control and reading
+   * loops. If a priority is given, it replaces the highest priority which libfranka would choose.
    */
-  explicit Robot(const std::string& robot_ip, const rclcpp::Logger& logger);
+  explicit Robot(const std::string& robot_ip,
+                 const rclcpp::Logger& logger,
+                 const ThreadSettings& control_thread_settings = ThreadSettings());
+
+  /**
+   * Uses a different backend than libfranka, e.g. a MockRobotBackend.
+   *
+   * @param[in] backend the backend to run the control and reading loops on.
+   * @param[im] logger ROS Logger to print eventual warnings.
+   * @param[in] control_thread_settings scheduling of the thread running the control and reading
+   * loops.
+   */
+  Robot(std::unique_ptr<RobotBackend> backend,
+        const rclcpp::Logger& logger,
+        const ThreadSettings& control_thread_settings = ThreadSettings());
   Robot(const Robot&) = delete;
   Robot& operator=(const Robot& other) = delete;
   Robot& operator=(Robot&& other) = delete;
@@ -45,45 +81,209 @@ class Robot {
   /// Stops the currently running loop and closes the connection with the robot.
   virtual ~Robot();
 
-  /**
-   * Starts a torque control loop. Before using this method make sure that no other
-   * control or reading loop is currently active.
+  /*
+   * The following methods switch the loop of the control thread. They only request the switch
+   * and return immediately. The control thread finishes the running loop and starts the requested
+   * one right away, so the robot state keeps being published during the switch. The thread is
+   * started on the first request and kept alive until stopRobot() is called.
    */
+
+  /// Switches to a torque control loop. The commanded torques are initialized with zero.
   void initializeTorqueControl();
 
   /**
-   * Starts a reading loop of the robot state. Before using this method make sure that no other
-   * control or reading loop is currently active.
+   * Switches to a control loop using the joint position motion generator of libfranka.
+   * @param[in] initial_positions the commanded positions until the first call of
+   * writeJointPositions(). Should be the current joint positions, so that the robot holds its pose.
+   */
+  void initializeJointPositionControl(const std::array<double, 7>& initial_positions);
+
+  /**
+   * Switches to a control loop using the joint velocity motion generator of libfranka. The
+   * commanded velocities are initialized with zero.
+   */
+  void initializeJointVelocityControl();
+
+  /**
+   * Switches to a control loop using the Cartesian velocity motion generator of libfranka. The
+   * commanded velocities are initialized with zero.
    */
+  void initializeCartesianVelocityControl();
+
+  /// Switches to a reading loop of the robot state.
   void initializeContinuousReading();
 
-  /// stops the control or reading loop of the robot.
+  /// Finishes the running loop and stops the control thread. Blocks until the thread is joined.
   void stopRobot();
 
   /**
-   * Get the current robot state in a thread-safe way.
-   * @return current robot state.
+   * Fetches the error which made the control thread abort the last control loop. After an error
+   * the control thread continues with a reading loop. If the reading loop fails as well, the
+   * control thread exits and the error is reported on every call until one of the initialize
+   * methods starts the thread again.
+   * @param[out] message description of the error.
+   * @return true if there was an error since the previous call or the control thread exited.
+   */
+  bool popError(std::string* message);
+
+  /**
+   * Selects which parts of the robot state are published in addition to the joint states. Only
+   * the selected fields are copied in the control loop. Before using this method make sure that
+   * no control or reading loop is currently active.
+   * @param[in] fields additional fields to publish.
+   */
+  void setStateFields(StateFieldMask fields);
+
+  /**
+   * Records every robot state and torque command of the control thread into recorder and dumps
+   * it when a loop aborts with an error. Before using this method make sure that no control or
+   * reading loop is currently active.
+   * @param[in] recorder the recorder to use, nullptr disables recording.
+   */
+  void setFlightRecorder(std::unique_ptr<FlightRecorder> recorder);
+
+  /// @return the recorder given to setFlightRecorder(), nullptr if there is none.
+  FlightRecorder* getFlightRecorder();
+
+  /**
+   * Get the current robot state without blocking the control loop. Must only be called from one
+   * thread at a time.
+   * @return snapshot of the current robot state. The reference stays valid until the next call.
+   */
+  const RobotStateSnapshot& read();
+
+  /**
+   * Busy waits until the control thread published a state which was not returned by read() yet.
+   * Must only be called from the thread calling read().
+   * @param[in] deadline when to give up waiting.
+   * @return true if there is a new state, false if the deadline passed or the control thread
+   * exited after an error.
    */
-  franka::RobotState read();
+  bool waitForNewState(std::chrono::steady_clock::time_point deadline);
 
   /**
-   * Sends new desired torque commands to the control loop in a thread-safe way.
+   * Sends new desired torque commands to the control loop without blocking it. Must only be
+   * called from one thread at a time.
    * The robot will use these torques until a different set of torques are commanded.
    * @param[in] efforts torque command for each joint.
    */
   void write(const std::array<double, 7>& efforts);
 
-  /// @return true if there is no control or reading loop running.
+  /**
+   * Sends new desired joint positions to the joint position control loop without blocking it.
+   * Must only be called from one thread at a time.
+   * @param[in] positions joint position command for each joint.
+   */
+  void writeJointPositions(const std::array<double, 7>& positions);
+
+  /**
+   * Sends new desired joint velocities to the joint velocity control loop without blocking it.
+   * Must only be called from one thread at a time. The velocities should be brought to zero before
+   * the loop is stopped, otherwise libfranka aborts the motion with an error.
+   * @param[in] velocities joint velocity command for each joint.
+   */
+  void writeJointVelocities(const std::array<double, 7>& velocities);
+
+  /**
+   * Sends a new desired end effector twist to the Cartesian velocity control loop without blocking
+   * it. Must only be called from one thread at a time. The velocities should be brought to zero
+   * before the loop is stopped, otherwise libfranka aborts the motion with an error.
+   * @param[in] velocities [vx, vy, vz, wx, wy, wz] of the end effector in the base frame.
+   */
+  void writeCartesianVelocities(const std::array<double, 6>& velocities);
+
+  /**
+   * Loads the dynamics model of the robot on first use. This method performs network
+   * communication and must not be called from a real-time context. An exception will be thrown
+   * if the model cannot be loaded.
+   * @return the model of the connected robot.
+   */
+  const franka::Model& getModel();
+
+  /// @return true if the control thread is not running, also after it exited on an error.
   bool isStopped() const;
 
+  /**
+   * Summarizes the timing of the control or reading loop since the previous call. Does not block
+   * the loop. Must only be called from one thread at a time.
+   * @return the statistics of the last interval.
+   */
+  Statistics collectStatistics();
+
  private:
+  using Clock = std::chrono::steady_clock;
+
+  /// copies the requested fields of state into the state buffer. Called from the control loop.
+  void publishState(const franka::RobotState& state);
+
+  /// records state into the flight recorder, if there is one. Called from the control loop.
+  void recordState(const franka::RobotState& state, const std::array<double, 7>& tau_command);
+
+  /// stores the time of a new command for the command age statistics.
+  void stampCommand();
+
+  /// The loops which can run in the control thread.
+  enum class Loop : uint8_t {
+    kReading,
+    kTorque,
+    kJointPosition,
+    kJointVelocity,
+    kCartesianVelocity,
+  };
+
+  /**
+   * Creates the libfranka callback of a control loop, which sends the latest command from
+   * command_buffer to the robot until a different loop is requested.
+   * @tparam Command libfranka command type, e.g. franka::Torques.
+   */
+  template <typename Command, size_t N>
+  std::function<Command(const franka::RobotState&, franka::Duration)> createControlCallback(
+      Loop loop,
+      TripleBuffer<std::array<double, N>>* command_buffer);
+
+  /// requests a loop and starts the control thread if it is not running (anymore).
+  void requestLoop(Loop loop);
+
+  /// body of the control thread. Runs the requested loops until finish_ is set.
+  void runLoops();
+
+  /// runs one loop until a different loop is requested or finish_ is set.
+  void runLoop(Loop loop);
+
+  /// @return true if the loop running in the control thread has to stop.
+  bool isFinished(Loop loop) const;
+
+  rclcpp::Logger logger_;
+  ThreadSettings control_thread_settings_;
   std::unique_ptr<std::thread> control_thread_;
-  std::unique_ptr<franka::Robot> robot_;
-  std::mutex read_mutex_;
-  std::mutex write_mutex_;
+  std::unique_ptr<RobotBackend> backend_;
+  std::unique_ptr<franka::Model> model_;
+  std::unique_ptr<FlightRecorder> flight_recorder_;
   std::atomic_bool finish_{false};
+  std::atomic<Loop> requested_loop_{Loop::kReading};
   bool stopped_ = true;
-  franka::RobotState current_state_;
-  std::array<double, 7> tau_command_{};
+  // set by the control thread when it exits because the reading loop failed, it is joined by
+  // the next requestLoop() or stopRobot()
+  std::atomic_bool exited_{false};
+  // error_message_ is written by the control thread while has_error_ is false and read by
+  // popError() while it is true
+  std::atomic_bool has_error_{false};
+  std::string error_message_;
+  StateFieldMask state_fields_ = 0;
+  // written by the libfranka callback, read by read()
+  TripleBuffer<RobotStateSnapshot> current_state_;
+  // written by the write methods, read by the libfranka callback of the matching control loop
+  TripleBuffer<std::array<double, 7>> tau_command_;
+  TripleBuffer<std::array<double, 7>> joint_position_command_;
+  TripleBuffer<std::array<double, 7>> joint_velocity_command_;
+  TripleBuffer<std::array<double, 6>> cartesian_velocity_command_;
+
+  // filled by the libfranka callback, read by collectStatistics()
+  LatencyHistogram callback_duration_;
+  LatencyHistogram command_age_;
+  LatencyHistogram state_interval_;
+  std::atomic<double> min_success_rate_{1};
+  std::atomic<int64_t> last_command_time_ns_{0};
+  int64_t last_state_time_ns_ = 0;  // only used by the libfranka callback
 };
 }  // namespace franka_hardware
@@ -0,0 +1,88 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/model.h>
+#include <franka/robot.h>
+#include <franka/robot_state.h>
+
+namespace franka_hardware {
+
+/**
+ * The source of robot states and the sink of commands of a Robot. Mirrors the blocking read and
+ * control loops of franka::Robot, which Robot runs in its control thread.
+ */
+class RobotBackend {
+ public:
+  template <typename Command>
+  using ControlCallback = std::function<Command(const franka::RobotState&, franka::Duration)>;
+
+  virtual ~RobotBackend() = default;
+
+  /**
+   * Calls callback with every new robot state until it returns false.
+   * @throw franka::Exception if the loop was aborted.
+   */
+  virtual void read(const std::function<bool(const franka::RobotState&)>& callback) = 0;
+
+  /**
+   * Runs a control loop which calls callback with every new robot state and sends the returned
+   * command, until a command has motion_finished set.
+   * @throw franka::Exception if the loop was aborted.
+   */
+  virtual void control(const ControlCallback<franka::Torques>& callback) = 0;
+  /// @copydoc control(const ControlCallback<franka::Torques>&)
+  virtual void control(const ControlCallback<franka::JointPositions>& callback) = 0;
+  /// @copydoc control(const ControlCallback<franka::Torques>&)
+  virtual void control(const ControlCallback<franka::JointVelocities>& callback) = 0;
+  /// @copydoc control(const ControlCallback<franka::Torques>&)
+  virtual void control(const ControlCallback<franka::CartesianVelocities>& callback) = 0;
+
+  /**
+   * Loads the dynamics model. Performs network communication.
+   * @throw franka::Exception if the model is not available.
+   */
+  virtual franka::Model loadModel() = 0;
+};
+
+/// Backend of a real robot, connected through libfranka.
+class LibfrankaBackend : public RobotBackend {
+ public:
+  /**
+   * Connects to the robot. This method can block for up to one minute if the robot is not
+   * responding. An exception will be thrown if the connection cannot be established.
+   * @param[in] robot_ip IP address or hostname of the robot.
+   * @param[in] realtime_config whether libfranka enforces a real-time kernel and priority.
+   */
+  LibfrankaBackend(const std::string& robot_ip, franka::RealtimeConfig realtime_config);
+
+  void read(const std::function<bool(const franka::RobotState&)>& callback) override;
+  void control(const ControlCallback<franka::Torques>& callback) override;
+  void control(const ControlCallback<franka::JointPositions>& callback) override;
+  void control(const ControlCallback<franka::JointVelocities>& callback) override;
+  void control(const ControlCallback<franka::CartesianVelocities>& callback) override;
+  franka::Model loadModel() override;
+
+ private:
+  std::unique_ptr<franka::Robot> robot_;
+};
+
+}  // namespace franka_hardware
@@ -0,0 +1,111 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <franka/robot_state.h>
+
+namespace franka_hardware {
+
+constexpr size_t kCacheLineSize = 64;
+
+/// Optional parts of franka::RobotState that can be added to a RobotStateSnapshot.
+enum class StateField : uint32_t {
+  kEndEffectorPose = 1U << 0U,            ///< O_T_EE
+  kExternalJointTorques = 1U << 1U,       ///< tau_ext_hat_filtered
+  kExternalWrenchInBase = 1U << 2U,       ///< O_F_ext_hat_K
+  kExternalWrenchInStiffness = 1U << 3U,  ///< K_F_ext_hat_K
+  kTotalLoad = 1U << 4U,                  ///< m_total, I_total and F_x_Ctotal
+};
+
+/// Set of StateField flags.
+using StateFieldMask = uint32_t;
+
+constexpr StateFieldMask toMask(StateField field) {
+  return static_cast<StateFieldMask>(field);
+}
+
+constexpr StateFieldMask operator|(StateField lhs, StateField rhs) {
+  return toMask(lhs) | toMask(rhs);
+}
+
+constexpr StateFieldMask operator|(StateFieldMask lhs, StateField rhs) {
+  return lhs | toMask(rhs);
+}
+
+constexpr bool hasField(StateFieldMask mask, StateField field) {
+  return (mask & toMask(field)) != 0;
+}
+
+/**
+ * Compact copy of the parts of franka::RobotState that are needed by the ros2_control loop.
+ * The joint states are always filled, all other members only if their StateField was requested.
+ * Member names follow the naming of franka::RobotState.
+ */
+struct alignas(kCacheLineSize) RobotStateSnapshot {
+  std::array<double, 7> q{};      ///< q
+  std::array<double, 7> dq{};     ///< dq
+  std::array<double, 7> tau_j{};  ///< tau_J
+
+  std::array<double, 16> o_t_ee{};               ///< O_T_EE
+  std::array<double, 7> tau_ext_hat_filtered{};  ///< tau_ext_hat_filtered
+  std::array<double, 6> o_f_ext_hat_k{};         ///< O_F_ext_hat_K
+  std::array<double, 6> k_f_ext_hat_k{};         ///< K_F_ext_hat_K
+  double m_total{};                              ///< m_total
+  std::array<double, 9> i_total{};               ///< I_total
+  std::array<double, 3> f_x_ctotal{};            ///< F_x_Ctotal
+
+  /// The fields which are filled in this snapshot.
+  StateFieldMask fields = 0;
+};
+
+/**
+ * Copies the joint states and the requested fields of a robot state into a snapshot. Members
+ * which were not requested are left untouched.
+ *
+ * @param[in] state full robot state as received from libfranka.
+ * @param[in] fields additional fields to copy.
+ * @param[out] snapshot the snapshot to fill.
+ */
+inline void projectRobotState(const franka::RobotState& state,
+                              StateFieldMask fields,
+                              RobotStateSnapshot* snapshot) {
+  snapshot->q = state.q;
+  snapshot->dq = state.dq;
+  snapshot->tau_j = state.tau_J;
+  if (hasField(fields, StateField::kEndEffectorPose)) {
+    snapshot->o_t_ee = state.O_T_EE;
+  }
+  if (hasField(fields, StateField::kExternalJointTorques)) {
+    snapshot->tau_ext_hat_filtered = state.tau_ext_hat_filtered;
+  }
+  if (hasField(fields, StateField::kExternalWrenchInBase)) {
+    snapshot->o_f_ext_hat_k = state.O_F_ext_hat_K;
+  }
+  if (hasField(fields, StateField::kExternalWrenchInStiffness)) {
+    snapshot->k_f_ext_hat_k = state.K_F_ext_hat_K;
+  }
+  if (hasField(fields, StateField::kTotalLoad)) {
+    snapshot->m_total = state.m_total;
+    snapshot->i_total = state.I_total;
+    snapshot->f_x_ctotal = state.F_x_Ctotal;
+  }
+  snapshot->fields = fields;
+}
+
+}  // namespace franka_hardware
@@ -0,0 +1,197 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+/*
+ * Layout of the shared memory which FrankaHardwareInterface exports the robot state to if the
+ * 'shared_state' parameter is set, and a client to read it. This header only needs POSIX, so
+ * other processes on the same host can use it without ROS or libfranka. Link with -lrt on glibc
+ * older than 2.34.
+ */
+
+namespace franka_hardware {
+
+/// Changes whenever SharedStateRegion changes.
+constexpr uint32_t kSharedStateVersion = 1;
+/// "FHSS" in little endian.
+constexpr uint32_t kSharedStateMagic = 0x53534846;
+
+/// @return the name of the shared memory object of an arm, i.e. /dev/shm/franka_hardware_<arm_id>.
+inline std::string getSharedStateName(const std::string& arm_id) {
+  return "/franka_hardware_" + arm_id;
+}
+
+/**
+ * Robot state of one controller_manager cycle, as returned by SharedStateReader. Member names
+ * follow the naming of franka::RobotState.
+ */
+struct SharedState {
+  /// CLOCK_MONOTONIC time in nanoseconds at which the state was exported.
+  int64_t stamp_ns = 0;
+
+  std::array<double, 7> q{};      ///< q
+  std::array<double, 7> dq{};     ///< dq
+  std::array<double, 7> tau_j{};  ///< tau_J
+
+  // only filled if requested by the 'extended_state_interfaces' parameter, see fields
+  std::array<double, 16> o_t_ee{};               ///< O_T_EE
+  std::array<double, 7> tau_ext_hat_filtered{};  ///< tau_ext_hat_filtered
+  std::array<double, 6> o_f_ext_hat_k{};         ///< O_F_ext_hat_K
+  std::array<double, 6> k_f_ext_hat_k{};         ///< K_F_ext_hat_K
+  double m_total{};                              ///< m_total
+  std::array<double, 9> i_total{};               ///< I_total
+  std::array<double, 3> f_x_ctotal{};            ///< F_x_Ctotal
+
+  /// StateFieldMask of the filled optional members, see robot_state_snapshot.hpp.
+  uint32_t fields = 0;
+  uint32_t reserved = 0;
+};
+static_assert(std::is_trivially_copyable<SharedState>::value, "SharedState is copied in words");
+static_assert(sizeof(SharedState) % sizeof(uint64_t) == 0, "SharedState is copied in words");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the seqlock needs lock-free atomics across processes");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the magic needs lock-free atomics across processes");
+
+/**
+ * The shared memory object, a seqlock around one SharedState.
+ *
+ * The writer increments sequence to an odd value, stores the words of the state and increments
+ * sequence to an even value again. A reader copies the words between two loads of sequence and
+ * retries if they differ or are odd. magic is stored with release ordering once version and size
+ * are written.
+ */
+struct SharedStateRegion {
+  static constexpr size_t kWords = sizeof(SharedState) / sizeof(uint64_t);
+
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  /// sizeof(SharedStateRegion)
+  uint32_t size;
+  uint32_t reserved;
+  /// own cache line, so that polling it does not hit the lines written with the state
+  alignas(64) std::atomic<uint64_t> sequence;
+  alignas(64) std::array<std::atomic<uint64_t>, kWords> data;
+};
+
+/**
+ * Reads the robot state exported by FrankaHardwareInterface from another process.
+ *
+ * read() never blocks the writer. It retries only if the writer was storing a new state while it
+ * copied, so it takes well below a microsecond. The retries are bounded, so that a writer which
+ * died while storing a state does not hang the reader.
+ */
+class SharedStateReader {
+ public:
+  /// How often read() copies the state before it gives up on a writer in the middle of write().
+  static constexpr int kMaxReadAttempts = 1000;
+
+  /**
+   * Maps the shared memory of an arm.
+   * @param[in] arm_id the arm_id of the robot.
+   * @throw std::system_error if the shared memory does not exist, is not initialized yet or has a
+   * different layout.
+   */
+  explicit SharedStateReader(const std::string& arm_id) {
+    const int kFile = shm_open(getSharedStateName(arm_id).c_str(), O_RDONLY, 0);
+    if (kFile < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "Could not open the shared state of " + arm_id);
+    }
+    // the writer sets the size after creating the object, mapping it before would fault
+    struct stat file_status {};
+    if (fstat(kFile, &file_status) != 0) {
+      const int kStatError = errno;
+      close(kFile);
+      throw std::system_error(kStatError, std::generic_category(),
+                              "Could not inspect the shared state of " + arm_id);
+    }
+    if (file_status.st_size < static_cast<off_t>(sizeof(SharedStateRegion))) {
+      close(kFile);
+      throw std::system_error(EAGAIN, std::generic_category(),
+                              "The shared state of " + arm_id + " is not initialized yet");
+    }
+    void* mapping = mmap(nullptr, sizeof(SharedStateRegion), PROT_READ, MAP_SHARED, kFile, 0);
+    const int kMapError = errno;
+    close(kFile);
+    if (mapping == MAP_FAILED) {
+      throw std::system_error(kMapError, std::generic_category(),
+                              "Could not map the shared state of " + arm_id);
+    }
+    region_ = static_cast<const SharedStateRegion*>(mapping);
+    if (region_->magic.load(std::memory_order_acquire) != kSharedStateMagic or
+        region_->version != kSharedStateVersion or
+        region_->size != sizeof(SharedStateRegion)) {
+      munmap(mapping, sizeof(SharedStateRegion));
+      throw std::system_error(EPROTO, std::generic_category(),
+                              "The shared state of " + arm_id + " has a different layout");
+    }
+  }
+
+  SharedStateReader(const SharedStateReader&) = delete;
+  SharedStateReader& operator=(const SharedStateReader&) = delete;
+  SharedStateReader(SharedStateReader&&) = delete;
+  SharedStateReader& operator=(SharedStateReader&&) = delete;
+
+  ~SharedStateReader() {
+    munmap(const_cast<SharedStateRegion*>(region_), sizeof(SharedStateRegion));
+  }
+
+  /**
+   * Copies the latest state.
+   * @param[out] state the state, unchanged if 0 is returned.
+   * @return the number of states exported so far. If it did not change since the previous call,
+   * the state is the same. 0 if there is no state yet or if no consistent state could be copied
+   * within kMaxReadAttempts, e.g. because the exporting process died in the middle of a write.
+   */
+  uint64_t read(SharedState* state) const {
+    std::array<uint64_t, SharedStateRegion::kWords> words{};
+    for (int attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+      const uint64_t kBefore = region_->sequence.load(std::memory_order_acquire);
+      if ((kBefore & 1U) != 0) {
+        continue;
+      }
+      for (size_t i = 0; i < words.size(); i++) {
+        words[i] = region_->data[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (region_->sequence.load(std::memory_order_relaxed) == kBefore) {
+        if (kBefore == 0) {
+          return 0;
+        }
+        std::memcpy(static_cast<void*>(state), words.data(), sizeof(SharedState));
+        return kBefore / 2;
+      }
+    }
+    return 0;
+  }
+
+ private:
+  const SharedStateRegion* region_ = nullptr;
+};
+
+}  // namespace franka_hardware
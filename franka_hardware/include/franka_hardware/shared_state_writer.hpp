@@ -0,0 +1,56 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <franka_hardware/robot_state_snapshot.hpp>
+#include <franka_hardware/shared_state.hpp>
+
+namespace franka_hardware {
+
+/// Exports the state of an arm into the shared memory read by SharedStateReader.
+class SharedStateWriter {
+ public:
+  /**
+   * Creates the shared memory of an arm, replacing a stale one of a previous run.
+   * @param[in] arm_id the arm_id of the robot.
+   * @throw std::system_error if the shared memory cannot be created.
+   */
+  explicit SharedStateWriter(const std::string& arm_id);
+  SharedStateWriter(const SharedStateWriter&) = delete;
+  SharedStateWriter& operator=(const SharedStateWriter&) = delete;
+  SharedStateWriter(SharedStateWriter&&) = delete;
+  SharedStateWriter& operator=(SharedStateWriter&&) = delete;
+
+  /// Unmaps and removes the shared memory. Mapped readers keep the last state.
+  ~SharedStateWriter();
+
+  /**
+   * Publishes a state. Wait-free and does not allocate. Must only be called from one thread.
+   * @param[in] snapshot the state of this cycle.
+   * @param[in] stamp_ns CLOCK_MONOTONIC time of the state in nanoseconds.
+   */
+  void write(const RobotStateSnapshot& snapshot, int64_t stamp_ns);
+
+ private:
+  std::string name_;
+  SharedStateRegion* region_ = nullptr;
+  // staging copy, converted to words
+  SharedState state_;
+};
+
+}  // namespace franka_hardware
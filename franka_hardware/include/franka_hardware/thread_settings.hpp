@@ -0,0 +1,55 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace franka_hardware {
+
+/// Scheduling settings of a real-time thread.
+struct ThreadSettings {
+  /// SCHED_FIFO priority. 0 keeps the scheduling policy of the creating thread.
+  int priority = 0;
+  /// CPUs the thread may run on. Empty keeps the affinity of the creating thread.
+  std::vector<int> cpus;
+  /// Touch the stack on start-up, so that no page faults happen later on.
+  bool prefault_stack = false;
+};
+
+/**
+ * Applies the settings to the calling thread.
+ * @param[in] settings settings to apply.
+ * @param[out] error description of the first setting that could not be applied.
+ * @return true if all settings were applied.
+ */
+bool applyToCurrentThread(const ThreadSettings& settings, std::string* error);
+
+/**
+ * Locks all current and future pages of the process into memory.
+ * @param[out] error description of the failure.
+ * @return true on success.
+ */
+bool lockMemory(std::string* error);
+
+/**
+ * Parses a list of CPU ids separated by commas or whitespace, e.g. "2,3".
+ * @param[in] list the list to parse.
+ * @param[out] cpus the parsed CPU ids.
+ * @return false if the list contains anything but non-negative integers.
+ */
+bool parseCpuList(const std::string& list, std::vector<int>* cpus);
+
+}  // namespace franka_hardware
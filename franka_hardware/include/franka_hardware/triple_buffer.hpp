@@ -0,0 +1,117 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace franka_hardware {
+
+/**
+ * Wait-free exchange of the latest value of type T between exactly one writer thread and exactly
+ * one reader thread.
+ *
+ * The writer and the reader each own one of three slots. The third slot is handed over through a
+ * single atomic index, so neither side ever blocks, retries or makes a system call. The reader
+ * always gets the most recently published complete value; intermediate values may be skipped.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+
+  /// @param[in] initial value returned by read() until the first value is published.
+  explicit TripleBuffer(const T& initial) { reset(initial); }
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+  TripleBuffer(TripleBuffer&&) = delete;
+  TripleBuffer& operator=(TripleBuffer&&) = delete;
+  ~TripleBuffer() = default;
+
+  /**
+   * Overwrites all slots. Must only be called while neither the writer nor the reader is active.
+   * @param[in] value new content of every slot.
+   */
+  void reset(const T& value) {
+    for (auto& slot : slots_) {
+      slot = value;
+    }
+    middle_.store(kInitialMiddle, std::memory_order_release);
+    write_index_ = kInitialWrite;
+    read_index_ = kInitialRead;
+  }
+
+  /**
+   * Gives the writer access to its private slot. The content is only visible to the reader after
+   * publish() was called. Writer side only.
+   * @return the slot to be filled by the writer.
+   */
+  T& writeBuffer() { return slots_.at(write_index_); }
+
+  /// Makes the content of writeBuffer() available to the reader. Writer side only.
+  void publish() {
+    const auto kPublished = static_cast<uint8_t>(write_index_ | kNewDataFlag);
+    const uint8_t kPrevious = middle_.exchange(kPublished, std::memory_order_acq_rel);
+    write_index_ = static_cast<uint8_t>(kPrevious & kIndexMask);
+  }
+
+  /**
+   * Copies value into the writer slot and publishes it. Writer side only.
+   * @param[in] value the value to publish.
+   */
+  void write(const T& value) {
+    writeBuffer() = value;
+    publish();
+  }
+
+  /**
+   * Takes ownership of the latest published value, if there is any. Reader side only.
+   * @return true if a value was published since the last call.
+   */
+  bool update() {
+    if ((middle_.load(std::memory_order_relaxed) & kNewDataFlag) == 0) {
+      return false;
+    }
+    const uint8_t kPrevious = middle_.exchange(read_index_, std::memory_order_acq_rel);
+    read_index_ = static_cast<uint8_t>(kPrevious & kIndexMask);
+    return true;
+  }
+
+  /**
+   * Returns the latest published value. Reader side only.
+   * @return reference to the reader slot. It stays valid until the next call to read() or
+   * update().
+   */
+  const T& read() {
+    update();
+    return slots_.at(read_index_);
+  }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kNewDataFlag = 0x4;
+  static constexpr uint8_t kInitialWrite = 0;
+  static constexpr uint8_t kInitialMiddle = 1;
+  static constexpr uint8_t kInitialRead = 2;
+
+  std::array<T, 3> slots_{};
+  std::atomic<uint8_t> middle_{kInitialMiddle};
+  uint8_t write_index_ = kInitialWrite;
+  uint8_t read_index_ = kInitialRead;
+};
+
+}  // namespace franka_hardware
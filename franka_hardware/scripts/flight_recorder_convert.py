@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#  Copyright (c) 2021 Franka Emika GmbH
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+"""Convert a flight recorder file of franka_hardware to CSV or MCAP."""
+
+import argparse
+import csv
+import json
+import math
+import struct
+import sys
+
+MAGIC = b'FRANKAFR'
+VERSION = 1
+HEADER = struct.Struct('<8sIIQQ')
+
+
+def read_recording(path):
+    """Return the column names, the reason of the dump and the records of a file."""
+    with open(path, 'rb') as recording:
+        data = recording.read()
+    magic, version, columns, records, text_size = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError('%s is not a flight recorder file' % path)
+    if version != VERSION:
+        raise ValueError('%s has version %d, expected %d' % (path, version, VERSION))
+    text = data[HEADER.size:HEADER.size + text_size].rstrip(b'\0').decode()
+    names, _, reason = text.partition('\n')
+    names = names.split(',')
+    if len(names) != columns:
+        raise ValueError('%s has %d column names for %d columns' % (path, len(names), columns))
+    record = struct.Struct('<%dd' % columns)
+    begin = HEADER.size + text_size
+    rows = list(record.iter_unpack(data[begin:begin + records * record.size]))
+    return names, reason, rows
+
+
+def write_csv(path, names, rows):
+    """Write one line per record."""
+    with open(path, 'w', newline='') as output:
+        writer = csv.writer(output)
+        writer.writerow(names)
+        writer.writerows(rows)
+
+
+def write_mcap(path, names, reason, rows):
+    """Write one JSON message per record on the /flight_recorder topic."""
+    try:
+        from mcap.writer import Writer
+    except ImportError:
+        sys.exit('Writing MCAP files needs the mcap package, e.g. "pip3 install mcap"')
+    schema = {'type': 'object',
+              'properties': {name: {'type': ['number', 'null']} for name in names}}
+    time_column = names.index('time')
+    with open(path, 'wb') as output:
+        writer = Writer(output)
+        writer.start()
+        writer.add_metadata('flight_recorder', {'reason': reason})
+        schema_id = writer.register_schema(
+            name='franka_hardware/FlightRecord', encoding='jsonschema',
+            data=json.dumps(schema).encode())
+        channel_id = writer.register_channel(
+            topic='/flight_recorder', message_encoding='json', schema_id=schema_id)
+        for row in rows:
+            # JSON has no NaN, e.g. for the torque command of other control modes
+            message = {name: value if math.isfinite(value) else None
+                       for name, value in zip(names, row)}
+            # robot time since its start
+            stamp = int(round(row[time_column] * 1e9))
+            writer.add_message(channel_id=channel_id, log_time=stamp, publish_time=stamp,
+                               data=json.dumps(message).encode())
+        writer.finish()
+
+
+def main():
+    """Convert the file given on the command line."""
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('recording', help='.frec file written by franka_hardware')
+    parser.add_argument('output', help='.csv or .mcap file to write')
+    args = parser.parse_args()
+
+    try:
+        names, reason, rows = read_recording(args.recording)
+    except (OSError, ValueError, struct.error) as error:
+        sys.exit(str(error))
+    print('%d records, dumped because of: %s' % (len(rows), reason))
+    if args.output.endswith('.mcap'):
+        write_mcap(args.output, names, reason, rows)
+    elif args.output.endswith('.csv'):
+        write_csv(args.output, names, rows)
+    else:
+        sys.exit('The output has to be a .csv or .mcap file')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,93 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/diagnostics_publisher.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+#include <diagnostic_msgs/msg/key_value.hpp>
+
+namespace franka_hardware {
+
+namespace {
+// how long the publisher thread waits for work before it checks if it should finish
+constexpr std::chrono::milliseconds kSpinTimeout{100};
+// libfranka aborts motions if too many commands are lost, so warn well before that
+constexpr double kSuccessRateWarningThreshold = 0.95;
+
+void addValue(const std::string& key,
+              double value,
+              diagnostic_msgs::msg::DiagnosticStatus* status) {
+  diagnostic_msgs::msg::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = std::to_string(value);
+  status->values.push_back(key_value);
+}
+
+void addSummary(const std::string& name,
+                const LatencyHistogram::Summary& summary,
+                diagnostic_msgs::msg::DiagnosticStatus* status) {
+  addValue(name + " count", static_cast<double>(summary.count), status);
+  addValue(name + " mean [us]", summary.mean_us, status);
+  addValue(name + " p50 [us]", summary.p50_us, status);
+  addValue(name + " p99 [us]", summary.p99_us, status);
+  addValue(name + " max [us]", summary.max_us, status);
+}
+}  // namespace
+
+DiagnosticsPublisher::DiagnosticsPublisher(Robot* robot,
+                                           const std::string& name,
+                                           std::chrono::nanoseconds period)
+    : robot_(robot), name_(name), node_(std::make_shared<rclcpp::Node>(name + "_diagnostics")) {
+  publisher_ = node_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 1);
+  timer_ = node_->create_wall_timer(period, [this]() { publish(); });
+  executor_.add_node(node_);
+  thread_ = std::thread([this]() {
+    while (not finish_ and rclcpp::ok()) {
+      executor_.spin_once(kSpinTimeout);
+    }
+  });
+}
+
+DiagnosticsPublisher::~DiagnosticsPublisher() {
+  finish_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void DiagnosticsPublisher::publish() {
+  const Robot::Statistics kStatistics = robot_->collectStatistics();
+
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = name_ + ": control loop";
+  status.hardware_id = name_;
+  if (kStatistics.min_success_rate < kSuccessRateWarningThreshold) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.message = "Commands are not reaching the robot in time";
+  } else {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "OK";
+  }
+  addSummary("callback duration", kStatistics.callback_duration, &status);
+  addSummary("command age", kStatistics.command_age, &status);
+  addSummary("state interval", kStatistics.state_interval, &status);
+  addValue("min control_command_success_rate", kStatistics.min_success_rate, &status);
+
+  diagnostic_msgs::msg::DiagnosticArray message;
+  message.header.stamp = node_->now();
+  message.status.push_back(status);
+  publisher_->publish(message);
+}
+
+}  // namespace franka_hardware
@@ -0,0 +1,270 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/flight_recorder.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include <rclcpp/logging.hpp>
+
+namespace franka_hardware {
+
+namespace {
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t columns;
+  uint64_t records;
+  uint64_t text_size;
+};
+static_assert(sizeof(FileHeader) == 32, "the reader expects a packed header");
+
+constexpr char kMagic[8] = {'F', 'R', 'A', 'N', 'K', 'A', 'F', 'R'};
+
+double hasErrors(const franka::Errors& errors) {
+  return static_cast<bool>(errors) ? 1 : 0;
+}
+
+/// Calls visit(name, value) for every recorded field, in file order. Values are doubles or arrays.
+template <typename Visitor>
+void visitFields(const franka::RobotState& state,
+                 const std::array<double, 7>& tau_command,
+                 Visitor* visit) {
+  (*visit)("time", state.time.toSec());
+  (*visit)("robot_mode", static_cast<double>(state.robot_mode));
+  (*visit)("control_command_success_rate", state.control_command_success_rate);
+  // the names of the errors are part of the error message stored with the dump
+  (*visit)("current_errors", hasErrors(state.current_errors));
+  (*visit)("last_motion_errors", hasErrors(state.last_motion_errors));
+  (*visit)("tau_command", tau_command);
+  (*visit)("q", state.q);
+  (*visit)("q_d", state.q_d);
+  (*visit)("dq", state.dq);
+  (*visit)("dq_d", state.dq_d);
+  (*visit)("ddq_d", state.ddq_d);
+  (*visit)("theta", state.theta);
+  (*visit)("dtheta", state.dtheta);
+  (*visit)("tau_J", state.tau_J);
+  (*visit)("tau_J_d", state.tau_J_d);
+  (*visit)("dtau_J", state.dtau_J);
+  (*visit)("tau_ext_hat_filtered", state.tau_ext_hat_filtered);
+  (*visit)("joint_contact", state.joint_contact);
+  (*visit)("joint_collision", state.joint_collision);
+  (*visit)("cartesian_contact", state.cartesian_contact);
+  (*visit)("cartesian_collision", state.cartesian_collision);
+  (*visit)("O_F_ext_hat_K", state.O_F_ext_hat_K);
+  (*visit)("K_F_ext_hat_K", state.K_F_ext_hat_K);
+  (*visit)("O_T_EE", state.O_T_EE);
+  (*visit)("O_T_EE_d", state.O_T_EE_d);
+  (*visit)("O_T_EE_c", state.O_T_EE_c);
+  (*visit)("O_dP_EE_d", state.O_dP_EE_d);
+  (*visit)("O_dP_EE_c", state.O_dP_EE_c);
+  (*visit)("O_ddP_EE_c", state.O_ddP_EE_c);
+  (*visit)("elbow", state.elbow);
+  (*visit)("elbow_d", state.elbow_d);
+  (*visit)("elbow_c", state.elbow_c);
+  (*visit)("delbow_c", state.delbow_c);
+  (*visit)("ddelbow_c", state.ddelbow_c);
+  (*visit)("F_T_EE", state.F_T_EE);
+  (*visit)("F_T_NE", state.F_T_NE);
+  (*visit)("NE_T_EE", state.NE_T_EE);
+  (*visit)("EE_T_K", state.EE_T_K);
+  (*visit)("m_ee", state.m_ee);
+  (*visit)("I_ee", state.I_ee);
+  (*visit)("F_x_Cee", state.F_x_Cee);
+  (*visit)("m_load", state.m_load);
+  (*visit)("I_load", state.I_load);
+  (*visit)("F_x_Cload", state.F_x_Cload);
+  (*visit)("m_total", state.m_total);
+  (*visit)("I_total", state.I_total);
+  (*visit)("F_x_Ctotal", state.F_x_Ctotal);
+}
+
+struct ColumnCollector {
+  void operator()(const char* name, double /*value*/) { columns.emplace_back(name); }
+
+  template <size_t N>
+  void operator()(const char* name, const std::array<double, N>& /*values*/) {
+    for (size_t i = 0; i < N; i++) {
+      columns.push_back(std::string(name) + "_" + std::to_string(i));
+    }
+  }
+
+  std::vector<std::string> columns;
+};
+
+struct ValueWriter {
+  void operator()(const char* /*name*/, double value) { *out++ = value; }
+
+  template <size_t N>
+  void operator()(const char* /*name*/, const std::array<double, N>& values) {
+    out = std::copy(values.begin(), values.end(), out);
+  }
+
+  double* out;
+};
+}  // namespace
+
+FlightRecorder::FlightRecorder(size_t capacity,
+                               std::string file_prefix,
+                               const rclcpp::Logger& logger)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      record_size_(columns().size()),
+      file_prefix_(std::move(file_prefix)),
+      logger_(logger),
+      // zero initialized, so all pages are touched before the control loop writes to them
+      records_(capacity_ * record_size_, 0.0) {
+  writer_thread_ = std::thread([this]() { runWriter(); });
+}
+
+FlightRecorder::~FlightRecorder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  dump_requested_.notify_one();
+  writer_thread_.join();
+}
+
+std::vector<std::string> FlightRecorder::columns() {
+  ColumnCollector collector;
+  visitFields(franka::RobotState(), {}, &collector);
+  return collector.columns;
+}
+
+void FlightRecorder::record(const franka::RobotState& state,
+                            const std::array<double, 7>& tau_command) {
+  const uint64_t kIndex = finished_.load(std::memory_order_relaxed);
+  // announces the slot before it is touched, so that writeFile() can tell if it copied a torn one
+  started_.store(kIndex + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  ValueWriter writer{&records_[(kIndex % capacity_) * record_size_]};
+  visitFields(state, tau_command, &writer);
+  finished_.store(kIndex + 1, std::memory_order_release);
+}
+
+bool FlightRecorder::dump(const std::string& reason, std::string* path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dump_pending_) {
+    return false;
+  }
+  const std::time_t kNow = std::time(nullptr);
+  std::tm local_time{};
+  localtime_r(&kNow, &local_time);
+  char time_string[32];
+  std::strftime(time_string, sizeof(time_string), "%Y%m%d_%H%M%S", &local_time);
+  // the counter keeps dumps within the same second apart
+  pending_path_ =
+      file_prefix_ + "_" + time_string + "_" + std::to_string(dump_count_++) + ".frec";
+  pending_reason_ = reason;
+  dump_pending_ = true;
+  *path = pending_path_;
+  dump_requested_.notify_one();
+  return true;
+}
+
+void FlightRecorder::runWriter() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    dump_requested_.wait(lock, [this]() { return shutdown_ or dump_pending_; });
+    if (not dump_pending_) {
+      return;
+    }
+    const std::string kPath = pending_path_;
+    const std::string kReason = pending_reason_;
+    lock.unlock();
+    writeFile(kPath, kReason);
+    lock.lock();
+    dump_pending_ = false;
+  }
+}
+
+void FlightRecorder::writeFile(const std::string& path, const std::string& reason) {
+  std::string text;
+  for (const auto& column : columns()) {
+    text += text.empty() ? column : "," + column;
+  }
+  text += "\n" + reason;
+  text.resize((text.size() + 7) / 8 * 8, '\0');
+  const size_t kRecordBytes = record_size_ * sizeof(double);
+  const size_t kHeaderBytes = sizeof(FileHeader) + text.size();
+
+  const uint64_t kEnd = finished_.load(std::memory_order_acquire);
+  const uint64_t kBegin = kEnd > capacity_ ? kEnd - capacity_ : 0;
+  const size_t kMappedBytes = kHeaderBytes + (kEnd - kBegin) * kRecordBytes;
+
+  const int kFile = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (kFile < 0) {
+    RCLCPP_ERROR(logger_, "Could not create flight recorder file '%s': %s", path.c_str(),
+                 std::strerror(errno));
+    return;
+  }
+  void* mapping = MAP_FAILED;
+  if (ftruncate(kFile, static_cast<off_t>(kMappedBytes)) == 0) {
+    mapping = mmap(nullptr, kMappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, kFile, 0);
+  }
+  if (mapping == MAP_FAILED) {
+    RCLCPP_ERROR(logger_, "Could not map flight recorder file '%s': %s", path.c_str(),
+                 std::strerror(errno));
+    close(kFile);
+    return;
+  }
+  auto* file = static_cast<char*>(mapping);
+  char* data = file + kHeaderBytes;
+
+  // oldest record first, the ring wraps at most once
+  const size_t kFirstSlot = kBegin % capacity_;
+  const size_t kFirstPart = std::min<size_t>(kEnd - kBegin, capacity_ - kFirstSlot);
+  std::memcpy(data, &records_[kFirstSlot * record_size_], kFirstPart * kRecordBytes);
+  std::memcpy(data + kFirstPart * kRecordBytes, records_.data(),
+              (kEnd - kBegin - kFirstPart) * kRecordBytes);
+
+  // records which record() started to overwrite in the meantime are dropped
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t kStarted = started_.load(std::memory_order_relaxed);
+  const uint64_t kFirstValid =
+      std::min(kEnd, std::max(kBegin, kStarted > capacity_ ? kStarted - capacity_ : 0));
+  const uint64_t kRecords = kEnd - kFirstValid;
+  std::memmove(data, data + (kFirstValid - kBegin) * kRecordBytes, kRecords * kRecordBytes);
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFileVersion;
+  header.columns = static_cast<uint32_t>(record_size_);
+  header.records = kRecords;
+  header.text_size = text.size();
+  std::memcpy(file, &header, sizeof(header));
+  std::memcpy(file + sizeof(header), text.data(), text.size());
+
+  munmap(mapping, kMappedBytes);
+  const size_t kFileBytes = kHeaderBytes + kRecords * kRecordBytes;
+  if (ftruncate(kFile, static_cast<off_t>(kFileBytes)) != 0 or fsync(kFile) != 0) {
+    RCLCPP_ERROR(logger_, "Could not write flight recorder file '%s': %s", path.c_str(),
+                 std::strerror(errno));
+  } else {
+    RCLCPP_INFO(logger_, "Wrote %lu ms of robot states to '%s'",
+                static_cast<unsigned long>(kRecords), path.c_str());
+  }
+  close(kFile);
+}
+
+}  // namespace franka_hardware
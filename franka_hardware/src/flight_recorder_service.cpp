@@ -0,0 +1,49 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/flight_recorder_service.hpp>
+
+namespace franka_hardware {
+
+namespace {
+// how long the service thread waits for work before it checks if it should finish
+constexpr std::chrono::milliseconds kSpinTimeout{100};
+}  // namespace
+
+FlightRecorderService::FlightRecorderService(FlightRecorder* recorder, const std::string& name)
+    : recorder_(recorder), node_(std::make_shared<rclcpp::Node>(name + "_flight_recorder")) {
+  service_ = node_->create_service<std_srvs::srv::Trigger>(
+      "~/dump", [this](const std::shared_ptr<std_srvs::srv::Trigger::Request> /*request*/,
+                       std::shared_ptr<std_srvs::srv::Trigger::Response> response) {
+        response->success = recorder_->dump("requested through the service", &response->message);
+        if (not response->success) {
+          response->message = "The previous dump is still being written";
+        }
+      });
+  executor_.add_node(node_);
+  thread_ = std::thread([this]() {
+    while (not finish_ and rclcpp::ok()) {
+      executor_.spin_once(kSpinTimeout);
+    }
+  });
+}
+
+FlightRecorderService::~FlightRecorderService() {
+  finish_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+}  // namespace franka_hardware
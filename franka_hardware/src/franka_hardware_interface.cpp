@@ -14,11 +14,17 @@
 
 #include <franka_hardware/franka_hardware_interface.hpp>
 
+#include <sched.h>
+
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <exception>
+#include <sstream>
+#include <system_error>
 
 #include <franka/exception.h>
+#include <franka_hardware/mock_robot_backend.hpp>
 #include <hardware_interface/handle.hpp>
 #include <hardware_interface/hardware_info.hpp>
 #include <hardware_interface/system_interface.hpp>
@@ -32,34 +38,139 @@ namespace franka_hardware {
 using StateInterface = hardware_interface::StateInterface;
 using CommandInterface = hardware_interface::CommandInterface;
 
+namespace {
+/// Exports every element of values as '<name>/<index>'
+template <size_t N>
+void exportArray(const std::string& name,
+                 std::array<double, N>& values,
+                 std::vector<StateInterface>& state_interfaces) {
+  for (auto i = 0U; i < N; i++) {
+    state_interfaces.emplace_back(StateInterface(name, std::to_string(i), &values.at(i)));
+  }
+}
+
+template <size_t N>
+bool allFinite(const std::array<double, N>& values) {
+  return std::all_of(values.begin(), values.end(), [](double c) { return std::isfinite(c); });
+}
+
+/// Splits a list separated by commas or spaces
+std::vector<std::string> splitList(const std::string& list) {
+  std::string separated_by_spaces = list;
+  std::replace(separated_by_spaces.begin(), separated_by_spaces.end(), ',', ' ');
+  std::istringstream stream(separated_by_spaces);
+  std::vector<std::string> elements;
+  std::string element;
+  while (stream >> element) {
+    elements.push_back(element);
+  }
+  return elements;
+}
+
+constexpr std::array<const char*, 6> kCartesianVelocityNames{"vx", "vy", "vz", "wx", "wy", "wz"};
+}  // namespace
+
 std::vector<StateInterface> FrankaHardwareInterface::export_state_interfaces() {
   std::vector<StateInterface> state_interfaces;
   for (auto i = 0U; i < info_.joints.size(); i++) {
+    Arm& arm = *arms_.at(i / kNumberOfJoints);
+    const size_t kJoint = i % kNumberOfJoints;
+    state_interfaces.emplace_back(StateInterface(
+        info_.joints[i].name, hardware_interface::HW_IF_POSITION, &arm.hw_positions.at(kJoint)));
     state_interfaces.emplace_back(StateInterface(
-        info_.joints[i].name, hardware_interface::HW_IF_POSITION, &hw_positions_.at(i)));
+        info_.joints[i].name, hardware_interface::HW_IF_VELOCITY, &arm.hw_velocities.at(kJoint)));
     state_interfaces.emplace_back(StateInterface(
-        info_.joints[i].name, hardware_interface::HW_IF_VELOCITY, &hw_velocities_.at(i)));
-    state_interfaces.emplace_back(
-        StateInterface(info_.joints[i].name, hardware_interface::HW_IF_EFFORT, &hw_efforts_.at(i)));
+        info_.joints[i].name, hardware_interface::HW_IF_EFFORT, &arm.hw_efforts.at(kJoint)));
+    if (hasField(state_fields_, StateField::kExternalJointTorques)) {
+      state_interfaces.emplace_back(StateInterface(info_.joints[i].name, "tau_ext_hat_filtered",
+                                                   &arm.hw_tau_ext_hat_filtered.at(kJoint)));
+    }
+    if (export_gravity_) {
+      state_interfaces.emplace_back(
+          StateInterface(info_.joints[i].name, "gravity", &arm.hw_gravity.at(kJoint)));
+    }
+    if (export_coriolis_) {
+      state_interfaces.emplace_back(
+          StateInterface(info_.joints[i].name, "coriolis", &arm.hw_coriolis.at(kJoint)));
+    }
+  }
+  for (auto& arm : arms_) {
+    if (hasField(state_fields_, StateField::kEndEffectorPose)) {
+      exportArray(arm->id + "_O_T_EE", arm->hw_o_t_ee, state_interfaces);
+    }
+    if (hasField(state_fields_, StateField::kExternalWrenchInBase)) {
+      exportArray(arm->id + "_O_F_ext_hat_K", arm->hw_o_f_ext_hat_k, state_interfaces);
+    }
+    if (hasField(state_fields_, StateField::kExternalWrenchInStiffness)) {
+      exportArray(arm->id + "_K_F_ext_hat_K", arm->hw_k_f_ext_hat_k, state_interfaces);
+    }
+    if (export_mass_) {
+      exportArray(arm->id + "_mass", arm->hw_mass, state_interfaces);
+    }
+    if (arm->gripper) {
+      // both fingers move symmetrically, each by half of the width
+      for (const auto* finger : {"_finger_joint1", "_finger_joint2"}) {
+        state_interfaces.emplace_back(StateInterface(
+            arm->id + finger, hardware_interface::HW_IF_POSITION, &arm->hw_finger_position));
+        state_interfaces.emplace_back(StateInterface(
+            arm->id + finger, hardware_interface::HW_IF_VELOCITY, &arm->hw_finger_velocity));
+      }
+      state_interfaces.emplace_back(
+          StateInterface(arm->id + "_gripper", "is_grasped", &arm->hw_gripper_is_grasped));
+    }
   }
   return state_interfaces;
 }
 
 std::vector<CommandInterface> FrankaHardwareInterface::export_command_interfaces() {
   std::vector<CommandInterface> command_interfaces;
-  command_interfaces.reserve(info_.joints.size());
+  command_interfaces.reserve(info_.joints.size() * joint_command_interfaces_.size() +
+                             arms_.size() * (kCartesianDimensions + 2));
   for (auto i = 0U; i < info_.joints.size(); i++) {
-    command_interfaces.emplace_back(CommandInterface(
-        info_.joints[i].name, hardware_interface::HW_IF_EFFORT, &hw_commands_.at(i)));
+    Arm& arm = *arms_.at(i / kNumberOfJoints);
+    const size_t kJoint = i % kNumberOfJoints;
+    for (const auto& interface : joint_command_interfaces_) {
+      double* command = &arm.hw_effort_commands.at(kJoint);
+      if (interface == hardware_interface::HW_IF_POSITION) {
+        command = &arm.hw_position_commands.at(kJoint);
+      } else if (interface == hardware_interface::HW_IF_VELOCITY) {
+        command = &arm.hw_velocity_commands.at(kJoint);
+      }
+      command_interfaces.emplace_back(CommandInterface(info_.joints[i].name, interface, command));
+    }
+  }
+  for (auto& arm : arms_) {
+    for (auto i = 0U; i < kCartesianDimensions; i++) {
+      command_interfaces.emplace_back(CommandInterface(arm->id + "_cartesian_velocity",
+                                                       kCartesianVelocityNames.at(i),
+                                                       &arm->hw_cartesian_velocity_commands.at(i)));
+    }
+    if (arm->gripper) {
+      command_interfaces.emplace_back(
+          CommandInterface(arm->id + "_gripper", "width", &arm->hw_gripper_width_command));
+      command_interfaces.emplace_back(
+          CommandInterface(arm->id + "_gripper", "force", &arm->hw_gripper_force_command));
+    }
   }
   return command_interfaces;
 }
 
 CallbackReturn FrankaHardwareInterface::on_activate(
     const rclcpp_lifecycle::State& /*previous_state*/) {
-  robot_->initializeContinuousReading();
-  hw_commands_.fill(0);
-  read();  // makes sure that the robot state is properly initialized.
+  for (auto& arm : arms_) {
+    arm->robot->initializeContinuousReading();
+    arm->running_mode = ControlMode::kNone;
+    arm->hw_effort_commands.fill(0);
+    arm->hw_velocity_commands.fill(0);
+    arm->hw_cartesian_velocity_commands.fill(0);
+    arm->hw_gripper_width_command = std::numeric_limits<double>::quiet_NaN();
+    arm->hw_gripper_force_command = 0;
+  }
+  // makes sure that the robot state is properly initialized. Not through read(), which applies
+  // the controller_manager thread settings to the calling thread, and this is not the update loop
+  for (auto& arm : arms_) {
+    readArm(arm.get());
+  }
   RCLCPP_INFO(getLogger(), "Started");
   return CallbackReturn::SUCCESS;
 }
@@ -67,26 +178,137 @@ CallbackReturn FrankaHardwareInterface::on_activate(
 CallbackReturn FrankaHardwareInterface::on_deactivate(
     const rclcpp_lifecycle::State& /*previous_state*/) {
   RCLCPP_INFO(getLogger(), "trying to Stop...");
-  robot_->stopRobot();
+  for (auto& arm : arms_) {
+    arm->robot->stopRobot();
+  }
   RCLCPP_INFO(getLogger(), "Stopped");
   return CallbackReturn::SUCCESS;
 }
 
 hardware_interface::return_type FrankaHardwareInterface::read() {
-  const auto kState = robot_->read();
-  hw_positions_ = kState.q;
-  hw_velocities_ = kState.dq;
-  hw_efforts_ = kState.tau_J;
-  return hardware_interface::return_type::OK;
+  if (not controller_manager_thread_configured_) {
+    std::string error;
+    if (not applyToCurrentThread(controller_manager_thread_settings_, &error)) {
+      RCLCPP_WARN(getLogger(), "controller_manager thread: %s", error.c_str());
+    }
+    controller_manager_thread_configured_ = true;
+  }
+  if (arms_.size() > 1 and arm_sync_timeout_.count() > 0) {
+    // the arms run on their own clocks, wait until all of them published the state of the current
+    // cycle, so that the controllers see the same instant of every arm
+    const auto kDeadline = std::chrono::steady_clock::now() + arm_sync_timeout_;
+    for (auto& arm : arms_) {
+      arm->robot->waitForNewState(kDeadline);
+    }
+  }
+  auto result = hardware_interface::return_type::OK;
+  for (auto& arm : arms_) {
+    if (not readArm(arm.get())) {
+      result = hardware_interface::return_type::ERROR;
+    }
+  }
+  return result;
 }
 
-hardware_interface::return_type FrankaHardwareInterface::write() {
-  if (std::any_of(hw_commands_.begin(), hw_commands_.end(),
-                  [](double c) { return not std::isfinite(c); })) {
-    return hardware_interface::return_type::ERROR;
+bool FrankaHardwareInterface::readArm(Arm* arm) {
+  if (arm->robot->popError(&error_message_)) {
+    RCLCPP_ERROR(getLogger(), "Control loop of %s aborted: %s", arm->id.c_str(),
+                 error_message_.c_str());
+    // the robot fell back to reading, so that claiming the mode again restarts the control loop
+    arm->running_mode = ControlMode::kNone;
+    return false;
+  }
+  const auto& kState = arm->robot->read();
+  if (arm->shared_state_writer) {
+    arm->shared_state_writer->write(
+        kState, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count());
+  }
+  arm->hw_positions = kState.q;
+  arm->hw_velocities = kState.dq;
+  arm->hw_efforts = kState.tau_j;
+  if (arm->gripper) {
+    const auto& kGripperState = arm->gripper->read();
+    arm->hw_finger_position = kGripperState.width / 2;
+    arm->hw_finger_velocity = kGripperState.width_velocity / 2;
+    arm->hw_gripper_is_grasped = kGripperState.is_grasped ? 1 : 0;
+  }
+  if (state_fields_ == 0) {
+    return true;
+  }
+  if (hasField(state_fields_, StateField::kEndEffectorPose)) {
+    arm->hw_o_t_ee = kState.o_t_ee;
+  }
+  if (hasField(state_fields_, StateField::kExternalJointTorques)) {
+    arm->hw_tau_ext_hat_filtered = kState.tau_ext_hat_filtered;
+  }
+  if (hasField(state_fields_, StateField::kExternalWrenchInBase)) {
+    arm->hw_o_f_ext_hat_k = kState.o_f_ext_hat_k;
+  }
+  if (hasField(state_fields_, StateField::kExternalWrenchInStiffness)) {
+    arm->hw_k_f_ext_hat_k = kState.k_f_ext_hat_k;
+  }
+  // the model terms are computed here once per cycle for all controllers
+  if (export_gravity_) {
+    arm->hw_gravity = arm->model->gravity(kState.q, kState.m_total, kState.f_x_ctotal);
   }
+  if (export_coriolis_) {
+    arm->hw_coriolis = arm->model->coriolis(kState.q, kState.dq, kState.i_total, kState.m_total,
+                                            kState.f_x_ctotal);
+  }
+  if (export_mass_) {
+    arm->hw_mass = arm->model->mass(kState.q, kState.i_total, kState.m_total, kState.f_x_ctotal);
+  }
+  return true;
+}
 
-  robot_->write(hw_commands_);
+hardware_interface::return_type FrankaHardwareInterface::write() {
+  // validate all commands first, so that either every arm or no arm gets a new command
+  for (const auto& arm : arms_) {
+    bool finite = true;
+    switch (arm->running_mode) {
+      case ControlMode::kEffort:
+        finite = allFinite(arm->hw_effort_commands);
+        break;
+      case ControlMode::kJointPosition:
+        finite = allFinite(arm->hw_position_commands);
+        break;
+      case ControlMode::kJointVelocity:
+        finite = allFinite(arm->hw_velocity_commands);
+        break;
+      case ControlMode::kCartesianVelocity:
+        finite = allFinite(arm->hw_cartesian_velocity_commands);
+        break;
+      case ControlMode::kNone:
+        break;
+    }
+    if (not finite) {
+      return hardware_interface::return_type::ERROR;
+    }
+  }
+  for (auto& arm : arms_) {
+    if (arm->gripper) {
+      // only sends a command if it changed, NaN is not sent
+      arm->gripper->write(arm->hw_gripper_width_command, arm->hw_gripper_force_command);
+    }
+    switch (arm->running_mode) {
+      case ControlMode::kEffort:
+        arm->robot->write(arm->hw_effort_commands);
+        break;
+      case ControlMode::kJointPosition:
+        arm->robot->writeJointPositions(arm->hw_position_commands);
+        break;
+      case ControlMode::kJointVelocity:
+        arm->robot->writeJointVelocities(arm->hw_velocity_commands);
+        break;
+      case ControlMode::kCartesianVelocity:
+        arm->robot->writeCartesianVelocities(arm->hw_cartesian_velocity_commands);
+        break;
+      case ControlMode::kNone:
+        break;
+    }
+  }
   return hardware_interface::return_type::OK;
 }
 
@@ -94,22 +316,60 @@ CallbackReturn FrankaHardwareInterface::on_init(const hardware_interface::Hardwa
   if (hardware_interface::SystemInterface::on_init(info) != CallbackReturn::SUCCESS) {
     return CallbackReturn::ERROR;
   }
-  if (info_.joints.size() != kNumberOfJoints) {
+  std::vector<std::string> robot_ips;
+  try {
+    robot_ips = splitList(info_.hardware_parameters.at("robot_ip"));
+  } catch (const std::out_of_range& ex) {
+    RCLCPP_FATAL(getLogger(), "Parameter 'robot_ip' not set");
+    return CallbackReturn::ERROR;
+  }
+  if (robot_ips.empty()) {
+    RCLCPP_FATAL(getLogger(), "Parameter 'robot_ip' not set");
+    return CallbackReturn::ERROR;
+  }
+  std::vector<std::string> arm_ids{"panda"};
+  const auto kArmId = info_.hardware_parameters.find("arm_id");
+  if (kArmId != info_.hardware_parameters.end()) {
+    arm_ids = splitList(kArmId->second);
+  }
+  if (arm_ids.size() != robot_ips.size()) {
+    RCLCPP_FATAL(getLogger(), "Got %ld robot IPs but %ld arm ids. Expected one arm id per robot.",
+                 robot_ips.size(), arm_ids.size());
+    return CallbackReturn::ERROR;
+  }
+  if (info_.joints.size() != kNumberOfJoints * robot_ips.size()) {
     RCLCPP_FATAL(getLogger(), "Got %ld joints. Expected %ld.", info_.joints.size(),
-                 kNumberOfJoints);
+                 kNumberOfJoints * robot_ips.size());
     return CallbackReturn::ERROR;
   }
 
+  for (const auto& interface : info_.joints[0].command_interfaces) {
+    joint_command_interfaces_.push_back(interface.name);
+  }
   for (const auto& joint : info_.joints) {
-    if (joint.command_interfaces.size() != 1) {
-      RCLCPP_FATAL(getLogger(), "Joint '%s' has %zu command interfaces found. 1 expected.",
-                   joint.name.c_str(), joint.command_interfaces.size());
+    if (joint.command_interfaces.empty()) {
+      RCLCPP_FATAL(getLogger(), "Joint '%s' has no command interfaces. At least 1 expected.",
+                   joint.name.c_str());
       return CallbackReturn::ERROR;
     }
-    if (joint.command_interfaces[0].name != hardware_interface::HW_IF_EFFORT) {
-      RCLCPP_FATAL(getLogger(), "Joint '%s' has unexpected command interface '%s'. Expected '%s'",
-                   joint.name.c_str(), joint.command_interfaces[0].name.c_str(),
-                   hardware_interface::HW_IF_EFFORT);
+    std::vector<std::string> interfaces;
+    for (const auto& interface : joint.command_interfaces) {
+      if (interface.name != hardware_interface::HW_IF_EFFORT and
+          interface.name != hardware_interface::HW_IF_POSITION and
+          interface.name != hardware_interface::HW_IF_VELOCITY) {
+        RCLCPP_FATAL(getLogger(),
+                     "Joint '%s' has unexpected command interface '%s'. Expected '%s', '%s' or '%s'",
+                     joint.name.c_str(), interface.name.c_str(), hardware_interface::HW_IF_EFFORT,
+                     hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY);
+        return CallbackReturn::ERROR;
+      }
+      interfaces.push_back(interface.name);
+    }
+    if (interfaces != joint_command_interfaces_) {
+      RCLCPP_FATAL(getLogger(),
+                   "Joint '%s' has different command interfaces than joint '%s'. All joints need "
+                   "the same command interfaces",
+                   joint.name.c_str(), info_.joints[0].name.c_str());
       return CallbackReturn::ERROR;
     }
     if (joint.state_interfaces.size() != 3) {
@@ -133,25 +393,251 @@ CallbackReturn FrankaHardwareInterface::on_init(const hardware_interface::Hardwa
                    hardware_interface::HW_IF_EFFORT);
     }
   }
-  std::string robot_ip;
-  try {
-    robot_ip = info_.hardware_parameters.at("robot_ip");
-  } catch (const std::out_of_range& ex) {
-    RCLCPP_FATAL(getLogger(), "Parameter 'robot_ip' not set");
+  double diagnostics_rate = 1.0;
+  const auto kDiagnosticsRate = info_.hardware_parameters.find("diagnostics_rate");
+  if (kDiagnosticsRate != info_.hardware_parameters.end()) {
+    try {
+      diagnostics_rate = std::stod(kDiagnosticsRate->second);
+    } catch (const std::exception& ex) {
+      RCLCPP_FATAL(getLogger(), "Parameter 'diagnostics_rate' is not a number: '%s'",
+                   kDiagnosticsRate->second.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+  double flight_recorder_duration = 0;
+  const auto kFlightRecorderDuration = info_.hardware_parameters.find("flight_recorder_duration");
+  if (kFlightRecorderDuration != info_.hardware_parameters.end()) {
+    try {
+      flight_recorder_duration = std::stod(kFlightRecorderDuration->second);
+    } catch (const std::exception& ex) {
+      RCLCPP_FATAL(getLogger(), "Parameter 'flight_recorder_duration' is not a number: '%s'",
+                   kFlightRecorderDuration->second.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+  const auto kFlightRecorderDirectory =
+      info_.hardware_parameters.find("flight_recorder_directory");
+  const std::string kFlightRecorderPath =
+      kFlightRecorderDirectory != info_.hardware_parameters.end()
+          ? kFlightRecorderDirectory->second
+          : "/tmp";
+  const auto kSharedState = info_.hardware_parameters.find("shared_state");
+  const bool kExportSharedState =
+      kSharedState != info_.hardware_parameters.end() and
+      (kSharedState->second == "true" or kSharedState->second == "True");
+  const auto kArmSyncTimeout = info_.hardware_parameters.find("arm_sync_timeout");
+  if (kArmSyncTimeout != info_.hardware_parameters.end()) {
+    try {
+      arm_sync_timeout_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double>(std::stod(kArmSyncTimeout->second)));
+    } catch (const std::exception& ex) {
+      RCLCPP_FATAL(getLogger(), "Parameter 'arm_sync_timeout' is not a number: '%s'",
+                   kArmSyncTimeout->second.c_str());
+      return CallbackReturn::ERROR;
+    }
+  } else {
+    // less than one cycle of the robots
+    arm_sync_timeout_ = std::chrono::microseconds(500);
+  }
+  ThreadSettings control_thread_settings;
+  if (not parseThreadSettings("control_thread", &control_thread_settings) or
+      not parseThreadSettings("controller_manager_thread", &controller_manager_thread_settings_)) {
     return CallbackReturn::ERROR;
   }
-  try {
-    RCLCPP_INFO(getLogger(), "Connecting to robot at \"%s\" ...", robot_ip.c_str());
-    robot_ = std::make_unique<Robot>(robot_ip, getLogger());
-  } catch (const franka::Exception& e) {
-    RCLCPP_FATAL(getLogger(), "Could not connect to robot");
-    RCLCPP_FATAL(getLogger(), "%s", e.what());
+  const auto kLockMemory = info_.hardware_parameters.find("lock_memory");
+  if (kLockMemory != info_.hardware_parameters.end() and
+      (kLockMemory->second == "true" or kLockMemory->second == "True")) {
+    std::string error;
+    if (not lockMemory(&error)) {
+      RCLCPP_FATAL(getLogger(), "%s", error.c_str());
+      return CallbackReturn::ERROR;
+    }
+    control_thread_settings.prefault_stack = true;
+    controller_manager_thread_settings_.prefault_stack = true;
+  }
+  const auto kBackend = info_.hardware_parameters.find("backend");
+  const bool kUseMock = kBackend != info_.hardware_parameters.end() and kBackend->second == "mock";
+  if (kBackend != info_.hardware_parameters.end() and not kUseMock and
+      kBackend->second != "libfranka") {
+    RCLCPP_FATAL(getLogger(), "Unknown backend '%s'. Expected 'libfranka' or 'mock'",
+                 kBackend->second.c_str());
+    return CallbackReturn::ERROR;
+  }
+  const auto kGripper = info_.hardware_parameters.find("gripper");
+  const bool kUseGripper = kGripper != info_.hardware_parameters.end() and
+                           (kGripper->second == "true" or kGripper->second == "True");
+  double gripper_speed = 0.1;
+  const auto kGripperSpeed = info_.hardware_parameters.find("gripper_speed");
+  if (kGripperSpeed != info_.hardware_parameters.end()) {
+    try {
+      gripper_speed = std::stod(kGripperSpeed->second);
+    } catch (const std::exception& ex) {
+      RCLCPP_FATAL(getLogger(), "Parameter 'gripper_speed' is not a number: '%s'",
+                   kGripperSpeed->second.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+  if (kUseMock and kUseGripper) {
+    RCLCPP_FATAL(getLogger(), "The gripper is not available with the mock backend");
+    return CallbackReturn::ERROR;
+  }
+  const auto kExtendedStateInterfaces = info_.hardware_parameters.find("extended_state_interfaces");
+  if (kExtendedStateInterfaces != info_.hardware_parameters.end() and
+      not parseExtendedStateInterfaces(kExtendedStateInterfaces->second)) {
     return CallbackReturn::ERROR;
   }
-  RCLCPP_INFO(getLogger(), "Successfully connected to robot");
+
+  for (size_t i = 0; i < robot_ips.size(); i++) {
+    auto arm = std::make_unique<Arm>();
+    arm->id = arm_ids.at(i);
+    const std::string& kRobotIp = robot_ips.at(i);
+    // '<arm_id>_control_thread_priority' and '_cpus' override the settings of all arms
+    ThreadSettings arm_thread_settings = control_thread_settings;
+    if (not parseThreadSettings(arm->id + "_control_thread", &arm_thread_settings)) {
+      return CallbackReturn::ERROR;
+    }
+    try {
+      if (kUseMock) {
+        RCLCPP_INFO(getLogger(), "Simulating robot %s with the mock backend", arm->id.c_str());
+        arm->robot = std::make_unique<Robot>(
+            std::make_unique<MockRobotBackend>(getInitialPositions(i)), getLogger(),
+            arm_thread_settings);
+      } else {
+        RCLCPP_INFO(getLogger(), "Connecting to robot at \"%s\" ...", kRobotIp.c_str());
+        arm->robot = std::make_unique<Robot>(kRobotIp, getLogger(), arm_thread_settings);
+      }
+    } catch (const franka::Exception& e) {
+      RCLCPP_FATAL(getLogger(), "Could not connect to robot");
+      RCLCPP_FATAL(getLogger(), "%s", e.what());
+      return CallbackReturn::ERROR;
+    }
+    RCLCPP_INFO(getLogger(), "Successfully connected to robot");
+    if (kUseGripper) {
+      try {
+        arm->gripper = std::make_unique<Gripper>(kRobotIp, getLogger(), gripper_speed);
+      } catch (const franka::Exception& e) {
+        RCLCPP_FATAL(getLogger(), "Could not connect to gripper");
+        RCLCPP_FATAL(getLogger(), "%s", e.what());
+        return CallbackReturn::ERROR;
+      }
+      RCLCPP_INFO(getLogger(), "Successfully connected to gripper");
+    }
+    arm->robot->setStateFields(state_fields_);
+    if (flight_recorder_duration > 0) {
+      // one record per millisecond
+      const auto kCapacity = static_cast<size_t>(flight_recorder_duration * 1000);
+      arm->robot->setFlightRecorder(std::make_unique<FlightRecorder>(
+          kCapacity, kFlightRecorderPath + "/" + arm->id, getLogger()));
+      arm->flight_recorder_service = std::make_unique<FlightRecorderService>(
+          arm->robot->getFlightRecorder(), arm->id);
+    }
+    if (kExportSharedState) {
+      try {
+        arm->shared_state_writer = std::make_unique<SharedStateWriter>(arm->id);
+      } catch (const std::system_error& e) {
+        RCLCPP_FATAL(getLogger(), "%s", e.what());
+        return CallbackReturn::ERROR;
+      }
+      RCLCPP_INFO(getLogger(), "Exporting the state of %s to shared memory %s", arm->id.c_str(),
+                  getSharedStateName(arm->id).c_str());
+    }
+    if (diagnostics_rate > 0) {
+      arm->diagnostics_publisher = std::make_unique<DiagnosticsPublisher>(
+          arm->robot.get(), arm->id,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::duration<double>(1.0 / diagnostics_rate)));
+    }
+    if (export_gravity_ or export_coriolis_ or export_mass_) {
+      try {
+        arm->model = &arm->robot->getModel();
+      } catch (const franka::Exception& e) {
+        RCLCPP_FATAL(getLogger(), "Could not load the robot model");
+        RCLCPP_FATAL(getLogger(), "%s", e.what());
+        return CallbackReturn::ERROR;
+      }
+    }
+    arms_.push_back(std::move(arm));
+  }
   return CallbackReturn::SUCCESS;
 }
 
+std::array<double, FrankaHardwareInterface::kNumberOfJoints>
+FrankaHardwareInterface::getInitialPositions(size_t arm) const {
+  std::array<double, kNumberOfJoints> positions{};
+  for (size_t i = 0; i < kNumberOfJoints; i++) {
+    const auto& kParameters = info_.joints.at(arm * kNumberOfJoints + i).parameters;
+    const auto kInitialPosition = kParameters.find("initial_position");
+    if (kInitialPosition != kParameters.end()) {
+      try {
+        positions.at(i) = std::stod(kInitialPosition->second);
+      } catch (const std::exception& ex) {
+        RCLCPP_WARN(getLogger(), "Ignoring initial_position '%s', it is not a number",
+                    kInitialPosition->second.c_str());
+      }
+    }
+  }
+  return positions;
+}
+
+bool FrankaHardwareInterface::parseThreadSettings(const std::string& prefix,
+                                                  ThreadSettings* settings) const {
+  const auto kPriority = info_.hardware_parameters.find(prefix + "_priority");
+  if (kPriority != info_.hardware_parameters.end()) {
+    try {
+      settings->priority = std::stoi(kPriority->second);
+    } catch (const std::exception& ex) {
+      RCLCPP_FATAL(getLogger(), "Parameter '%s' is not a number: '%s'", kPriority->first.c_str(),
+                   kPriority->second.c_str());
+      return false;
+    }
+    if (settings->priority < sched_get_priority_min(SCHED_FIFO) or
+        settings->priority > sched_get_priority_max(SCHED_FIFO)) {
+      RCLCPP_FATAL(getLogger(), "Parameter '%s' must be a SCHED_FIFO priority between %d and %d",
+                   kPriority->first.c_str(), sched_get_priority_min(SCHED_FIFO),
+                   sched_get_priority_max(SCHED_FIFO));
+      return false;
+    }
+  }
+  const auto kCpus = info_.hardware_parameters.find(prefix + "_cpus");
+  if (kCpus != info_.hardware_parameters.end() and
+      not parseCpuList(kCpus->second, &settings->cpus)) {
+    RCLCPP_FATAL(getLogger(), "Parameter '%s' is not a list of CPU ids: '%s'",
+                 kCpus->first.c_str(), kCpus->second.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool FrankaHardwareInterface::parseExtendedStateInterfaces(const std::string& interfaces) {
+  for (const auto& interface : splitList(interfaces)) {
+    if (interface == "O_T_EE") {
+      state_fields_ |= toMask(StateField::kEndEffectorPose);
+    } else if (interface == "tau_ext_hat_filtered") {
+      state_fields_ |= toMask(StateField::kExternalJointTorques);
+    } else if (interface == "O_F_ext_hat_K") {
+      state_fields_ |= toMask(StateField::kExternalWrenchInBase);
+    } else if (interface == "K_F_ext_hat_K") {
+      state_fields_ |= toMask(StateField::kExternalWrenchInStiffness);
+    } else if (interface == "gravity") {
+      export_gravity_ = true;
+    } else if (interface == "coriolis") {
+      export_coriolis_ = true;
+    } else if (interface == "mass") {
+      export_mass_ = true;
+    } else {
+      RCLCPP_FATAL(getLogger(),
+                   "Unknown extended state interface '%s'. Expected one of O_T_EE, "
+                   "tau_ext_hat_filtered, O_F_ext_hat_K, K_F_ext_hat_K, gravity, coriolis, mass",
+                   interface.c_str());
+      return false;
+    }
+  }
+  if (export_gravity_ or export_coriolis_ or export_mass_) {
+    state_fields_ |= toMask(StateField::kTotalLoad);
+  }
+  return true;
+}
+
 rclcpp::Logger FrankaHardwareInterface::getLogger() {
   return rclcpp::get_logger("FrankaHardwareInterface");
 }
@@ -159,14 +645,33 @@ rclcpp::Logger FrankaHardwareInterface::getLogger() {
 hardware_interface::return_type FrankaHardwareInterface::perform_command_mode_switch(
     const std::vector<std::string>& /*start_interfaces*/,
     const std::vector<std::string>& /*stop_interfaces*/) {
-  if (not effort_interface_running_ and effort_interface_claimed_) {
-    robot_->stopRobot();
-    robot_->initializeTorqueControl();
-    effort_interface_running_ = true;
-  } else if (effort_interface_running_ and not effort_interface_claimed_) {
-    robot_->stopRobot();
-    robot_->initializeContinuousReading();
-    effort_interface_running_ = false;
+  for (auto& arm : arms_) {
+    if (arm->claimed_mode == arm->running_mode) {
+      continue;
+    }
+    // only requests the switch, the control thread finishes the running loop on its own
+    switch (arm->claimed_mode) {
+      case ControlMode::kEffort:
+        arm->hw_effort_commands.fill(0);
+        arm->robot->initializeTorqueControl();
+        break;
+      case ControlMode::kJointPosition:
+        arm->hw_position_commands = arm->hw_positions;
+        arm->robot->initializeJointPositionControl(arm->hw_position_commands);
+        break;
+      case ControlMode::kJointVelocity:
+        arm->hw_velocity_commands.fill(0);
+        arm->robot->initializeJointVelocityControl();
+        break;
+      case ControlMode::kCartesianVelocity:
+        arm->hw_cartesian_velocity_commands.fill(0);
+        arm->robot->initializeCartesianVelocityControl();
+        break;
+      case ControlMode::kNone:
+        arm->robot->initializeContinuousReading();
+        break;
+    }
+    arm->running_mode = arm->claimed_mode;
   }
   return hardware_interface::return_type::OK;
 }
@@ -174,35 +679,140 @@ hardware_interface::return_type FrankaHardwareInterface::perform_command_mode_sw
 hardware_interface::return_type FrankaHardwareInterface::prepare_command_mode_switch(
     const std::vector<std::string>& start_interfaces,
     const std::vector<std::string>& stop_interfaces) {
-  auto is_effort_interface = [](const std::string& interface) {
-    return interface.find(hardware_interface::HW_IF_EFFORT) != std::string::npos;
+  using Counts = std::array<size_t, kNumberOfControlModes>;
+  auto count_interfaces = [this](const std::vector<std::string>& interfaces) {
+    std::vector<Counts> counts(arms_.size(), Counts{});
+    for (const auto& interface : interfaces) {
+      size_t arm = 0;
+      const ControlMode kMode = getControlMode(interface, &arm);
+      if (kMode != ControlMode::kNone) {
+        counts.at(arm).at(static_cast<size_t>(kMode))++;
+      }
+    }
+    return counts;
   };
+  const std::array<ControlMode, kNumberOfControlModes - 1> kModes{
+      ControlMode::kEffort, ControlMode::kJointPosition, ControlMode::kJointVelocity,
+      ControlMode::kCartesianVelocity};
 
-  int64_t num_stop_effort_interfaces =
-      std::count_if(stop_interfaces.begin(), stop_interfaces.end(), is_effort_interface);
-  if (num_stop_effort_interfaces == kNumberOfJoints) {
-    effort_interface_claimed_ = false;
-  } else if (num_stop_effort_interfaces != 0) {
-    RCLCPP_FATAL(this->getLogger(), "Expected %ld effort interfaces to stop, but got %ld instead.",
-                 kNumberOfJoints, num_stop_effort_interfaces);
-    std::string error_string = "Invalid number of effort interfaces to stop. Expected ";
-    error_string += std::to_string(kNumberOfJoints);
-    throw std::invalid_argument(error_string);
-  }
-
-  int64_t num_start_effort_interfaces =
-      std::count_if(start_interfaces.begin(), start_interfaces.end(), is_effort_interface);
-  if (num_start_effort_interfaces == kNumberOfJoints) {
-    effort_interface_claimed_ = true;
-  } else if (num_start_effort_interfaces != 0) {
-    RCLCPP_FATAL(this->getLogger(), "Expected %ld effort interfaces to start, but got %ld instead.",
-                 kNumberOfJoints, num_start_effort_interfaces);
-    std::string error_string = "Invalid number of effort interfaces to start. Expected ";
-    error_string += std::to_string(kNumberOfJoints);
-    throw std::invalid_argument(error_string);
+  const auto kStopCounts = count_interfaces(stop_interfaces);
+  const auto kStartCounts = count_interfaces(start_interfaces);
+  // only applied if the switch is valid for every arm
+  std::vector<ControlMode> modes(arms_.size());
+  for (size_t arm = 0; arm < arms_.size(); arm++) {
+    ControlMode mode = arms_.at(arm)->claimed_mode;
+    for (const auto kMode : kModes) {
+      const size_t kCount = kStopCounts.at(arm).at(static_cast<size_t>(kMode));
+      if (kCount == 0) {
+        continue;
+      }
+      if (kCount != getNumberOfInterfaces(kMode)) {
+        RCLCPP_FATAL(this->getLogger(), "Expected %ld %s interfaces to stop, but got %ld instead.",
+                     getNumberOfInterfaces(kMode), toString(kMode), kCount);
+        std::string error_string = "Invalid number of ";
+        error_string += toString(kMode);
+        error_string += " interfaces to stop. Expected ";
+        error_string += std::to_string(getNumberOfInterfaces(kMode));
+        throw std::invalid_argument(error_string);
+      }
+      if (mode == kMode) {
+        mode = ControlMode::kNone;
+      }
+    }
+
+    for (const auto kMode : kModes) {
+      const size_t kCount = kStartCounts.at(arm).at(static_cast<size_t>(kMode));
+      if (kCount == 0) {
+        continue;
+      }
+      if (kCount != getNumberOfInterfaces(kMode)) {
+        RCLCPP_FATAL(this->getLogger(), "Expected %ld %s interfaces to start, but got %ld instead.",
+                     getNumberOfInterfaces(kMode), toString(kMode), kCount);
+        std::string error_string = "Invalid number of ";
+        error_string += toString(kMode);
+        error_string += " interfaces to start. Expected ";
+        error_string += std::to_string(getNumberOfInterfaces(kMode));
+        throw std::invalid_argument(error_string);
+      }
+      if (mode != ControlMode::kNone) {
+        RCLCPP_ERROR(this->getLogger(),
+                     "Cannot claim %s interfaces of %s while %s interfaces are in use.",
+                     toString(kMode), arms_.at(arm)->id.c_str(), toString(mode));
+        return hardware_interface::return_type::ERROR;
+      }
+      mode = kMode;
+    }
+    modes.at(arm) = mode;
+  }
+  for (size_t arm = 0; arm < arms_.size(); arm++) {
+    arms_.at(arm)->claimed_mode = modes.at(arm);
   }
   return hardware_interface::return_type::OK;
 }
+
+FrankaHardwareInterface::ControlMode FrankaHardwareInterface::getControlMode(
+    const std::string& interface,
+    size_t* arm) const {
+  for (size_t i = 0; i < arms_.size(); i++) {
+    const std::string kCartesianVelocityPrefix = arms_.at(i)->id + "_cartesian_velocity/";
+    if (interface.compare(0, kCartesianVelocityPrefix.size(), kCartesianVelocityPrefix) == 0) {
+      *arm = i;
+      return ControlMode::kCartesianVelocity;
+    }
+  }
+  const auto kSeparator = interface.rfind('/');
+  if (kSeparator == std::string::npos) {
+    return ControlMode::kNone;
+  }
+  const std::string kJoint = interface.substr(0, kSeparator);
+  const auto kJointInfo =
+      std::find_if(info_.joints.begin(), info_.joints.end(),
+                   [&kJoint](const auto& joint) { return joint.name == kJoint; });
+  if (kJointInfo == info_.joints.end()) {
+    return ControlMode::kNone;
+  }
+  const std::string kInterface = interface.substr(kSeparator + 1);
+  ControlMode mode = ControlMode::kNone;
+  if (kInterface == hardware_interface::HW_IF_EFFORT) {
+    mode = ControlMode::kEffort;
+  } else if (kInterface == hardware_interface::HW_IF_POSITION) {
+    mode = ControlMode::kJointPosition;
+  } else if (kInterface == hardware_interface::HW_IF_VELOCITY) {
+    mode = ControlMode::kJointVelocity;
+  }
+  *arm = static_cast<size_t>(kJointInfo - info_.joints.begin()) / kNumberOfJoints;
+  return mode;
+}
+
+size_t FrankaHardwareInterface::getNumberOfInterfaces(ControlMode mode) {
+  switch (mode) {
+    case ControlMode::kEffort:
+    case ControlMode::kJointPosition:
+    case ControlMode::kJointVelocity:
+      return kNumberOfJoints;
+    case ControlMode::kCartesianVelocity:
+      return kCartesianDimensions;
+    case ControlMode::kNone:
+      break;
+  }
+  return 0;
+}
+
+const char* FrankaHardwareInterface::toString(ControlMode mode) {
+  switch (mode) {
+    case ControlMode::kEffort:
+      return "effort";
+    case ControlMode::kJointPosition:
+      return "joint position";
+    case ControlMode::kJointVelocity:
+      return "joint velocity";
+    case ControlMode::kCartesianVelocity:
+      return "Cartesian velocity";
+    case ControlMode::kNone:
+      break;
+  }
+  return "no";
+}
 }  // namespace franka_hardware
 
 #include "pluginlib/class_list_macros.hpp"
@@ -0,0 +1,136 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/gripper.hpp>
+
+#include <chrono>
+#include <cmath>
+
+#include <franka/exception.h>
+#include <rclcpp/logging.hpp>
+
+namespace franka_hardware {
+
+namespace {
+// the grasp succeeds if the width of the grasped object is within this tolerance of the command
+constexpr double kGraspEpsilon = 0.005;
+}  // namespace
+
+Gripper::Gripper(const std::string& robot_ip, const rclcpp::Logger& logger, double speed)
+    : logger_(logger), speed_(speed), gripper_(std::make_unique<franka::Gripper>(robot_ip)) {
+  const auto kInitialState = gripper_->readOnce();
+  current_state_.reset({kInitialState.width, 0, kInitialState.is_grasped});
+  reader_thread_ = std::thread([this]() { runReader(); });
+  command_thread_ = std::thread([this]() { runCommands(); });
+}
+
+Gripper::~Gripper() {
+  {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    shutdown_ = true;
+    stopCommand();
+  }
+  command_available_.notify_one();
+  command_thread_.join();
+  // readOnce() returns with the next state the gripper sends
+  reader_thread_.join();
+}
+
+const Gripper::State& Gripper::read() {
+  return current_state_.read();
+}
+
+void Gripper::write(double width, double force) {
+  if (std::isnan(width) or (width == last_command_.width and force == last_command_.force)) {
+    return;
+  }
+  // retried in the next cycle if the command thread holds the lock
+  std::unique_lock<std::mutex> lock(command_mutex_, std::try_to_lock);
+  if (not lock.owns_lock()) {
+    return;
+  }
+  last_command_ = {width, force};
+  pending_command_ = last_command_;
+  command_pending_ = true;
+  lock.unlock();
+  command_available_.notify_one();
+}
+
+void Gripper::runReader() {
+  franka::GripperState previous = gripper_->readOnce();
+  while (not shutdown_) {
+    franka::GripperState state;
+    try {
+      state = gripper_->readOnce();
+    } catch (const franka::Exception& e) {
+      RCLCPP_ERROR(logger_, "Could not read the gripper state: %s", e.what());
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      continue;
+    }
+    const double kDt = state.time.toSec() - previous.time.toSec();
+    auto& published = current_state_.writeBuffer();
+    published.width = state.width;
+    published.width_velocity = kDt > 0 ? (state.width - previous.width) / kDt : 0;
+    published.is_grasped = state.is_grasped;
+    current_state_.publish();
+    previous = state;
+
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    if (command_pending_) {
+      stopCommand();
+    }
+  }
+}
+
+void Gripper::runCommands() {
+  std::unique_lock<std::mutex> lock(command_mutex_);
+  while (true) {
+    command_available_.wait(lock, [this]() { return shutdown_ or command_pending_; });
+    if (shutdown_) {
+      return;
+    }
+    const Command kCommand = pending_command_;
+    command_pending_ = false;
+    command_running_ = true;
+    command_stopped_ = false;
+    lock.unlock();
+    try {
+      if (kCommand.force > 0) {
+        gripper_->grasp(kCommand.width, speed_, kCommand.force, kGraspEpsilon, kGraspEpsilon);
+      } else {
+        gripper_->move(kCommand.width, speed_);
+      }
+    } catch (const franka::Exception& e) {
+      RCLCPP_WARN(logger_, "Gripper command to width %f did not finish: %s", kCommand.width,
+                  e.what());
+    }
+    lock.lock();
+    command_running_ = false;
+  }
+}
+
+void Gripper::stopCommand() {
+  // called with command_mutex_ locked, so the command thread cannot start the next command
+  // before the stop arrived at the gripper
+  if (not command_running_ or command_stopped_) {
+    return;
+  }
+  command_stopped_ = true;
+  try {
+    gripper_->stop();
+  } catch (const franka::Exception& e) {
+    RCLCPP_ERROR(logger_, "Could not stop the gripper: %s", e.what());
+  }
+}
+}  // namespace franka_hardware
@@ -0,0 +1,78 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/latency_histogram.hpp>
+
+#include <algorithm>
+
+namespace franka_hardware {
+
+constexpr int64_t LatencyHistogram::kBucketWidthNs;
+constexpr size_t LatencyHistogram::kNumberOfBuckets;
+
+namespace {
+constexpr double kNanosecondsPerMicrosecond = 1e3;
+}  // namespace
+
+void LatencyHistogram::record(int64_t duration_ns) {
+  duration_ns = std::max<int64_t>(duration_ns, 0);
+  const auto kBucket =
+      std::min(static_cast<size_t>(duration_ns / kBucketWidthNs), kNumberOfBuckets - 1);
+  buckets_.at(kBucket).fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+  int64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+  while (duration_ns > max_ns and
+         not max_ns_.compare_exchange_weak(max_ns, duration_ns, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Summary LatencyHistogram::collect() {
+  std::array<uint64_t, kNumberOfBuckets> counts{};
+  Summary summary;
+  for (size_t i = 0; i < kNumberOfBuckets; i++) {
+    const uint64_t kTotal = buckets_.at(i).load(std::memory_order_relaxed);
+    counts.at(i) = kTotal - collected_buckets_.at(i);
+    collected_buckets_.at(i) = kTotal;
+    summary.count += counts.at(i);
+  }
+  const int64_t kSum = sum_ns_.load(std::memory_order_relaxed);
+  const int64_t kMax = max_ns_.exchange(0, std::memory_order_relaxed);
+  if (summary.count == 0) {
+    collected_sum_ns_ = kSum;
+    return summary;
+  }
+  summary.mean_us = static_cast<double>(kSum - collected_sum_ns_) /
+                    static_cast<double>(summary.count) / kNanosecondsPerMicrosecond;
+  collected_sum_ns_ = kSum;
+  summary.max_us = static_cast<double>(kMax) / kNanosecondsPerMicrosecond;
+
+  // the upper edge of the bucket which contains the requested rank
+  auto percentile = [&](double fraction) {
+    const auto kRank = static_cast<uint64_t>(fraction * static_cast<double>(summary.count - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumberOfBuckets - 1; i++) {
+      seen += counts.at(i);
+      if (seen > kRank) {
+        return std::min(static_cast<double>((i + 1) * kBucketWidthNs) / kNanosecondsPerMicrosecond,
+                        summary.max_us);
+      }
+    }
+    return summary.max_us;
+  };
+  summary.p50_us = percentile(0.5);
+  summary.p99_us = percentile(0.99);
+  return summary;
+}
+
+}  // namespace franka_hardware
@@ -0,0 +1,135 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/mock_robot_backend.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include <franka/exception.h>
+
+namespace franka_hardware {
+
+namespace {
+constexpr std::chrono::milliseconds kPeriod{1};
+constexpr double kPeriodSeconds = 1e-3;
+// of every simulated joint
+constexpr double kInertia = 1.0;  // kg m^2
+constexpr double kDamping = 2.0;  // Nm s/rad
+
+template <size_t N>
+void checkFinite(const std::array<double, N>& values) {
+  if (not std::all_of(values.begin(), values.end(), [](double v) { return std::isfinite(v); })) {
+    throw franka::ControlException("Mock robot: commanded values must be finite");
+  }
+}
+}  // namespace
+
+MockRobotBackend::MockRobotBackend(const std::array<double, 7>& initial_positions) {
+  state_.q = initial_positions;
+  state_.q_d = initial_positions;
+  state_.O_T_EE = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+  state_.control_command_success_rate = 1;
+}
+
+void MockRobotBackend::read(const std::function<bool(const franka::RobotState&)>& callback) {
+  first_cycle_ = true;
+  do {
+    waitForNextCycle();
+  } while (callback(state_));
+}
+
+void MockRobotBackend::control(const ControlCallback<franka::Torques>& callback) {
+  runControl<franka::Torques>(callback, [this](const franka::Torques& command) {
+    checkFinite(command.tau_J);
+    for (size_t i = 0; i < state_.q.size(); i++) {
+      const double kAcceleration = (command.tau_J.at(i) - kDamping * state_.dq.at(i)) / kInertia;
+      state_.dq.at(i) += kAcceleration * kPeriodSeconds;
+      state_.q.at(i) += state_.dq.at(i) * kPeriodSeconds;
+    }
+    state_.tau_J = command.tau_J;
+    state_.q_d = state_.q;
+  });
+}
+
+void MockRobotBackend::control(const ControlCallback<franka::JointPositions>& callback) {
+  runControl<franka::JointPositions>(callback, [this](const franka::JointPositions& command) {
+    checkFinite(command.q);
+    for (size_t i = 0; i < state_.q.size(); i++) {
+      state_.dq.at(i) = (command.q.at(i) - state_.q.at(i)) / kPeriodSeconds;
+    }
+    state_.q = command.q;
+    state_.q_d = command.q;
+  });
+}
+
+void MockRobotBackend::control(const ControlCallback<franka::JointVelocities>& callback) {
+  runControl<franka::JointVelocities>(callback, [this](const franka::JointVelocities& command) {
+    checkFinite(command.dq);
+    for (size_t i = 0; i < state_.q.size(); i++) {
+      state_.q.at(i) += command.dq.at(i) * kPeriodSeconds;
+    }
+    state_.dq = command.dq;
+    state_.q_d = state_.q;
+  });
+}
+
+void MockRobotBackend::control(const ControlCallback<franka::CartesianVelocities>& callback) {
+  runControl<franka::CartesianVelocities>(
+      callback, [this](const franka::CartesianVelocities& command) {
+        checkFinite(command.O_dP_EE);
+        // there is no kinematics model, the joints stand still
+        state_.dq = {};
+      });
+}
+
+franka::Model MockRobotBackend::loadModel() {
+  throw franka::ModelException("Mock robot: no dynamics model available");
+}
+
+template <typename Command>
+void MockRobotBackend::runControl(const ControlCallback<Command>& callback,
+                                  const std::function<void(const Command&)>& apply) {
+  first_cycle_ = true;
+  franka::Duration period(0);
+  while (true) {
+    waitForNextCycle();
+    const Command kCommand = callback(state_, period);
+    apply(kCommand);
+    if (kCommand.motion_finished) {
+      return;
+    }
+    period = franka::Duration(1);
+  }
+}
+
+void MockRobotBackend::waitForNextCycle() {
+  if (first_cycle_) {
+    first_cycle_ = false;
+    next_cycle_ = Clock::now();
+    return;
+  }
+  next_cycle_ += kPeriod;
+  const auto kNow = Clock::now();
+  if (next_cycle_ < kNow) {
+    // the callback was too slow, the robot would have dropped these cycles
+    next_cycle_ = kNow;
+  } else {
+    std::this_thread::sleep_until(next_cycle_);
+  }
+  state_.time = state_.time + franka::Duration(1);
+}
+
+}  // namespace franka_hardware
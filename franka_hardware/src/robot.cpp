@@ -15,33 +15,137 @@
 #include <franka_hardware/robot.hpp>
 
 #include <cassert>
-#include <mutex>
+#include <limits>
+#include <utility>
 
 #include <franka/control_tools.h>
+#include <franka/exception.h>
 #include <rclcpp/logging.hpp>
 
 namespace franka_hardware {
 
-Robot::Robot(const std::string& robot_ip, const rclcpp::Logger& logger) {
-  tau_command_.fill(0.);
+namespace {
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+// recorded instead of the torque command by loops which do not command torques
+const std::array<double, 7> kNoTorqueCommand = {kNaN, kNaN, kNaN, kNaN, kNaN, kNaN, kNaN};
+
+template <typename Command>
+const std::array<double, 7>& getTorqueCommand(const Command& /*command*/) {
+  return kNoTorqueCommand;
+}
+
+const std::array<double, 7>& getTorqueCommand(const franka::Torques& command) {
+  return command.tau_J;
+}
+
+int64_t toNanoseconds(std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+}  // namespace
+
+Robot::Robot(const std::string& robot_ip,
+             const rclcpp::Logger& logger,
+             const ThreadSettings& control_thread_settings)
+    : logger_(logger), control_thread_settings_(control_thread_settings) {
+  tau_command_.reset({});
   franka::RealtimeConfig rt_config = franka::RealtimeConfig::kEnforce;
-  if (not franka::hasRealtimeKernel()) {
+  if (control_thread_settings_.priority > 0) {
+    // the priority is set by the control thread, libfranka must not overwrite it
+    rt_config = franka::RealtimeConfig::kIgnore;
+  } else if (not franka::hasRealtimeKernel()) {
     rt_config = franka::RealtimeConfig::kIgnore;
     RCLCPP_WARN(
         logger,
         "You are not using a real-time kernel. Using a real-time kernel is strongly recommended!");
   }
-  robot_ = std::make_unique<franka::Robot>(robot_ip, rt_config);
+  backend_ = std::make_unique<LibfrankaBackend>(robot_ip, rt_config);
+}
+
+Robot::Robot(std::unique_ptr<RobotBackend> backend,
+             const rclcpp::Logger& logger,
+             const ThreadSettings& control_thread_settings)
+    : logger_(logger),
+      control_thread_settings_(control_thread_settings),
+      backend_(std::move(backend)) {
+  tau_command_.reset({});
 }
 
 void Robot::write(const std::array<double, 7>& efforts) {
-  std::lock_guard<std::mutex> lock(write_mutex_);
-  tau_command_ = efforts;
+  tau_command_.write(efforts);
+  stampCommand();
+}
+
+void Robot::writeJointPositions(const std::array<double, 7>& positions) {
+  joint_position_command_.write(positions);
+  stampCommand();
+}
+
+void Robot::writeJointVelocities(const std::array<double, 7>& velocities) {
+  joint_velocity_command_.write(velocities);
+  stampCommand();
+}
+
+void Robot::writeCartesianVelocities(const std::array<double, 6>& velocities) {
+  cartesian_velocity_command_.write(velocities);
+  stampCommand();
+}
+
+void Robot::setStateFields(StateFieldMask fields) {
+  assert(isStopped());
+  state_fields_ = fields;
+}
+
+void Robot::setFlightRecorder(std::unique_ptr<FlightRecorder> recorder) {
+  assert(isStopped());
+  flight_recorder_ = std::move(recorder);
+}
+
+FlightRecorder* Robot::getFlightRecorder() {
+  return flight_recorder_.get();
+}
+
+const RobotStateSnapshot& Robot::read() {
+  return current_state_.read();
+}
+
+bool Robot::waitForNewState(std::chrono::steady_clock::time_point deadline) {
+  // update() takes the new state, so that the following read() returns it
+  while (not current_state_.update()) {
+    if (exited_.load(std::memory_order_acquire) or Clock::now() >= deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+const franka::Model& Robot::getModel() {
+  if (not model_) {
+    model_ = std::make_unique<franka::Model>(backend_->loadModel());
+  }
+  return *model_;
+}
+
+void Robot::publishState(const franka::RobotState& state) {
+  projectRobotState(state, state_fields_, &current_state_.writeBuffer());
+  current_state_.publish();
+
+  const int64_t kNow = toNanoseconds(Clock::now());
+  if (last_state_time_ns_ != 0) {
+    state_interval_.record(kNow - last_state_time_ns_);
+  }
+  last_state_time_ns_ = kNow;
+}
+
+void Robot::recordState(const franka::RobotState& state,
+                        const std::array<double, 7>& tau_command) {
+  if (flight_recorder_) {
+    flight_recorder_->record(state, tau_command);
+  }
 }
 
-franka::RobotState Robot::read() {
-  std::lock_guard<std::mutex> lock(read_mutex_);
-  return {current_state_};
+void Robot::stampCommand() {
+  last_command_time_ns_.store(toNanoseconds(Clock::now()), std::memory_order_relaxed);
 }
 
 void Robot::stopRobot() {
@@ -50,42 +154,157 @@ void Robot::stopRobot() {
     control_thread_->join();
     finish_ = false;
     stopped_ = true;
+    exited_ = false;
   }
 }
 
-void Robot::initializeTorqueControl() {
-  assert(isStopped());
-  stopped_ = false;
-  const auto kTorqueControl = [this]() {
-    robot_->control(
-        [this](const franka::RobotState& state, const franka::Duration& /*period*/) {
-          {
-            std::lock_guard<std::mutex> lock(read_mutex_);
-            current_state_ = state;
-          }
-          std::lock_guard<std::mutex> lock(write_mutex_);
-          franka::Torques out(tau_command_);
-          out.motion_finished = finish_;
-          return out;
-        },
-        true, franka::kMaxCutoffFrequency);
+bool Robot::popError(std::string* message) {
+  if (exited_.load(std::memory_order_acquire)) {
+    // nothing reads the robot anymore, keep reporting until a loop is requested again
+    *message = error_message_;
+    return true;
+  }
+  if (not has_error_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *message = error_message_;
+  has_error_.store(false, std::memory_order_release);
+  return true;
+}
+
+bool Robot::isFinished(Loop loop) const {
+  return finish_ or requested_loop_.load(std::memory_order_relaxed) != loop;
+}
+
+template <typename Command, size_t N>
+std::function<Command(const franka::RobotState&, franka::Duration)> Robot::createControlCallback(
+    Loop loop,
+    TripleBuffer<std::array<double, N>>* command_buffer) {
+  return [this, loop, command_buffer](const franka::RobotState& state,
+                                      franka::Duration /*period*/) {
+    const int64_t kStart = toNanoseconds(Clock::now());
+    publishState(state);
+    Command out(command_buffer->read());
+    recordState(state, getTorqueCommand(out));
+    const int64_t kCommandTime = last_command_time_ns_.load(std::memory_order_relaxed);
+    if (kCommandTime != 0) {
+      command_age_.record(kStart - kCommandTime);
+    }
+    double min_success_rate = min_success_rate_.load(std::memory_order_relaxed);
+    while (state.control_command_success_rate < min_success_rate and
+           not min_success_rate_.compare_exchange_weak(
+               min_success_rate, state.control_command_success_rate, std::memory_order_relaxed)) {
+    }
+    out.motion_finished = isFinished(loop);
+    callback_duration_.record(toNanoseconds(Clock::now()) - kStart);
+    return out;
   };
-  control_thread_ = std::make_unique<std::thread>(kTorqueControl);
 }
 
-void Robot::initializeContinuousReading() {
-  assert(isStopped());
-  stopped_ = false;
-  const auto kReading = [this]() {
-    robot_->read([this](const franka::RobotState& state) {
-      {
-        std::lock_guard<std::mutex> lock(read_mutex_);
-        current_state_ = state;
+void Robot::requestLoop(Loop loop) {
+  requested_loop_ = loop;
+  if (not stopped_ and exited_.load(std::memory_order_acquire)) {
+    // the reading loop failed before, the thread is done and only has to be joined
+    control_thread_->join();
+    stopped_ = true;
+  }
+  if (stopped_) {
+    stopped_ = false;
+    exited_ = false;
+    has_error_ = false;
+    control_thread_ = std::make_unique<std::thread>([this]() { runLoops(); });
+  }
+}
+
+void Robot::runLoops() {
+  std::string error;
+  if (not applyToCurrentThread(control_thread_settings_, &error)) {
+    RCLCPP_WARN(logger_, "Control thread: %s", error.c_str());
+  }
+  last_state_time_ns_ = 0;
+  while (not finish_) {
+    const Loop kLoop = requested_loop_.load();
+    try {
+      runLoop(kLoop);
+    } catch (const franka::Exception& e) {
+      if (not has_error_.load(std::memory_order_acquire)) {
+        error_message_ = e.what();
+        has_error_.store(true, std::memory_order_release);
       }
-      return not finish_;
-    });
-  };
-  control_thread_ = std::make_unique<std::thread>(kReading);
+      std::string path;
+      if (flight_recorder_ and flight_recorder_->dump(e.what(), &path)) {
+        RCLCPP_ERROR(logger_, "Writing the robot states before the error to '%s'", path.c_str());
+      }
+      // keep the state flowing, unless a different loop was requested in the meantime
+      Loop expected = kLoop;
+      requested_loop_.compare_exchange_strong(expected, Loop::kReading);
+      if (kLoop == Loop::kReading) {
+        // the connection is broken, do not spin on it. Published after error_message_ was written
+        exited_.store(true, std::memory_order_release);
+        return;
+      }
+    }
+  }
+}
+
+void Robot::runLoop(Loop loop) {
+  switch (loop) {
+    case Loop::kReading:
+      backend_->read([this](const franka::RobotState& state) {
+        publishState(state);
+        recordState(state, kNoTorqueCommand);
+        return not isFinished(Loop::kReading);
+      });
+      break;
+    case Loop::kTorque:
+      backend_->control(createControlCallback<franka::Torques>(loop, &tau_command_));
+      break;
+    case Loop::kJointPosition:
+      backend_->control(
+          createControlCallback<franka::JointPositions>(loop, &joint_position_command_));
+      break;
+    case Loop::kJointVelocity:
+      backend_->control(
+          createControlCallback<franka::JointVelocities>(loop, &joint_velocity_command_));
+      break;
+    case Loop::kCartesianVelocity:
+      backend_->control(
+          createControlCallback<franka::CartesianVelocities>(loop, &cartesian_velocity_command_));
+      break;
+  }
+}
+
+void Robot::initializeTorqueControl() {
+  write({});
+  requestLoop(Loop::kTorque);
+}
+
+void Robot::initializeJointPositionControl(const std::array<double, 7>& initial_positions) {
+  writeJointPositions(initial_positions);
+  requestLoop(Loop::kJointPosition);
+}
+
+void Robot::initializeJointVelocityControl() {
+  writeJointVelocities({});
+  requestLoop(Loop::kJointVelocity);
+}
+
+void Robot::initializeCartesianVelocityControl() {
+  writeCartesianVelocities({});
+  requestLoop(Loop::kCartesianVelocity);
+}
+
+void Robot::initializeContinuousReading() {
+  requestLoop(Loop::kReading);
+}
+
+Robot::Statistics Robot::collectStatistics() {
+  Statistics statistics;
+  statistics.callback_duration = callback_duration_.collect();
+  statistics.command_age = command_age_.collect();
+  statistics.state_interval = state_interval_.collect();
+  statistics.min_success_rate = min_success_rate_.exchange(1);
+  return statistics;
 }
 
 Robot::~Robot() {
@@ -93,6 +312,6 @@ Robot::~Robot() {
 }
 
 bool Robot::isStopped() const {
-  return stopped_;
+  return stopped_ or exited_.load(std::memory_order_acquire);
 }
 }  // namespace franka_hardware
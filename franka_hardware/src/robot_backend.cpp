@@ -0,0 +1,52 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/robot_backend.hpp>
+
+#include <franka/control_tools.h>
+
+namespace franka_hardware {
+
+LibfrankaBackend::LibfrankaBackend(const std::string& robot_ip,
+                                   franka::RealtimeConfig realtime_config)
+    : robot_(std::make_unique<franka::Robot>(robot_ip, realtime_config)) {}
+
+void LibfrankaBackend::read(const std::function<bool(const franka::RobotState&)>& callback) {
+  robot_->read(callback);
+}
+
+void LibfrankaBackend::control(const ControlCallback<franka::Torques>& callback) {
+  robot_->control(callback, true, franka::kMaxCutoffFrequency);
+}
+
+void LibfrankaBackend::control(const ControlCallback<franka::JointPositions>& callback) {
+  robot_->control(callback, franka::ControllerMode::kJointImpedance, true,
+                  franka::kMaxCutoffFrequency);
+}
+
+void LibfrankaBackend::control(const ControlCallback<franka::JointVelocities>& callback) {
+  robot_->control(callback, franka::ControllerMode::kJointImpedance, true,
+                  franka::kMaxCutoffFrequency);
+}
+
+void LibfrankaBackend::control(const ControlCallback<franka::CartesianVelocities>& callback) {
+  robot_->control(callback, franka::ControllerMode::kCartesianImpedance, true,
+                  franka::kMaxCutoffFrequency);
+}
+
+franka::Model LibfrankaBackend::loadModel() {
+  return robot_->loadModel();
+}
+
+}  // namespace franka_hardware
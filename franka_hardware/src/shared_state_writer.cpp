@@ -0,0 +1,79 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/shared_state_writer.hpp>
+
+#include <new>
+
+namespace franka_hardware {
+
+SharedStateWriter::SharedStateWriter(const std::string& arm_id)
+    : name_(getSharedStateName(arm_id)) {
+  // a new object, readers of a previous run keep their mapping of the old one
+  shm_unlink(name_.c_str());
+  const int kFile = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (kFile < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "Could not create the shared memory " + name_);
+  }
+  void* mapping = MAP_FAILED;
+  if (ftruncate(kFile, sizeof(SharedStateRegion)) == 0) {
+    mapping =
+        mmap(nullptr, sizeof(SharedStateRegion), PROT_READ | PROT_WRITE, MAP_SHARED, kFile, 0);
+  }
+  const int kError = errno;
+  close(kFile);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name_.c_str());
+    throw std::system_error(kError, std::generic_category(),
+                            "Could not map the shared memory " + name_);
+  }
+  // ftruncate() zero filled the memory, i.e. sequence 0 and an empty state
+  region_ = new (mapping) SharedStateRegion;
+  region_->version = kSharedStateVersion;
+  region_->size = sizeof(SharedStateRegion);
+  region_->magic.store(kSharedStateMagic, std::memory_order_release);
+}
+
+SharedStateWriter::~SharedStateWriter() {
+  munmap(region_, sizeof(SharedStateRegion));
+  shm_unlink(name_.c_str());
+}
+
+void SharedStateWriter::write(const RobotStateSnapshot& snapshot, int64_t stamp_ns) {
+  state_.stamp_ns = stamp_ns;
+  state_.q = snapshot.q;
+  state_.dq = snapshot.dq;
+  state_.tau_j = snapshot.tau_j;
+  state_.o_t_ee = snapshot.o_t_ee;
+  state_.tau_ext_hat_filtered = snapshot.tau_ext_hat_filtered;
+  state_.o_f_ext_hat_k = snapshot.o_f_ext_hat_k;
+  state_.k_f_ext_hat_k = snapshot.k_f_ext_hat_k;
+  state_.m_total = snapshot.m_total;
+  state_.i_total = snapshot.i_total;
+  state_.f_x_ctotal = snapshot.f_x_ctotal;
+  state_.fields = snapshot.fields;
+
+  std::array<uint64_t, SharedStateRegion::kWords> words{};
+  std::memcpy(words.data(), &state_, sizeof(SharedState));
+  const uint64_t kSequence = region_->sequence.load(std::memory_order_relaxed);
+  region_->sequence.store(kSequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < words.size(); i++) {
+    region_->data[i].store(words[i], std::memory_order_relaxed);
+  }
+  region_->sequence.store(kSequence + 2, std::memory_order_release);
+}
+
+}  // namespace franka_hardware
@@ -0,0 +1,98 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <franka_hardware/thread_settings.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace franka_hardware {
+
+namespace {
+// covers the stack usage of the libfranka control loop including the controller callbacks
+constexpr size_t kStackPrefaultSize = 512 * 1024;
+
+// noinline, so the array is really placed on the stack of the calling thread
+__attribute__((noinline)) void prefaultStack() {
+  std::array<unsigned char, kStackPrefaultSize> stack;
+  std::memset(stack.data(), 0, stack.size());
+  // keeps the compiler from optimizing the memset away
+  asm volatile("" : : "r"(stack.data()) : "memory");
+}
+}  // namespace
+
+bool applyToCurrentThread(const ThreadSettings& settings, std::string* error) {
+  if (settings.priority > 0) {
+    sched_param parameters{};
+    parameters.sched_priority = settings.priority;
+    const int kResult = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+    if (kResult != 0) {
+      *error = "Could not set SCHED_FIFO priority " + std::to_string(settings.priority) + ": " +
+               std::strerror(kResult);
+      return false;
+    }
+  }
+  if (not settings.cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int kCpu : settings.cpus) {
+      CPU_SET(kCpu, &cpu_set);
+    }
+    const int kResult = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (kResult != 0) {
+      *error = std::string("Could not set the CPU affinity: ") + std::strerror(kResult);
+      return false;
+    }
+  }
+  if (settings.prefault_stack) {
+    prefaultStack();
+  }
+  return true;
+}
+
+bool lockMemory(std::string* error) {
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    *error = std::string("Could not lock memory: ") + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool parseCpuList(const std::string& list, std::vector<int>* cpus) {
+  std::string separated_by_spaces = list;
+  std::replace(separated_by_spaces.begin(), separated_by_spaces.end(), ',', ' ');
+  std::istringstream stream(separated_by_spaces);
+  std::vector<int> parsed;
+  int cpu = 0;
+  while (stream >> cpu) {
+    if (cpu < 0 or cpu >= CPU_SETSIZE) {
+      return false;
+    }
+    parsed.push_back(cpu);
+  }
+  if (not stream.eof()) {
+    return false;
+  }
+  *cpus = parsed;
+  return true;
+}
+
+}  // namespace franka_hardware
@@ -0,0 +1,345 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of the trajectory sampling and the controller update. Besides the time per
+// iteration, every benchmark reports the heap allocations of the benchmark thread as allocs/op.
+// Build with -DBUILD_BENCHMARKS=ON and run
+//   ros2 run joint_effort_trajectory_controller joint_trajectory_controller_benchmark
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_effort_trajectory_controller/joint_trajectory_controller.hpp"
+#include "joint_effort_trajectory_controller/trajectory.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+// only the benchmark thread, the middleware threads allocate independently of the benchmarks
+thread_local size_t thread_allocations = 0;
+}  // namespace
+
+void * operator new(std::size_t size)
+{
+  ++thread_allocations;
+  if (void * pointer = std::malloc(size == 0 ? 1 : size))
+  {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * pointer) noexcept { std::free(pointer); }
+
+void operator delete(void * pointer, std::size_t) noexcept { std::free(pointer); }
+
+namespace
+{
+using joint_trajectory_controller::JointTrajectoryController;
+using joint_trajectory_controller::Trajectory;
+using joint_trajectory_controller::TrajectoryPointConstIter;
+using trajectory_msgs::msg::JointTrajectory;
+using trajectory_msgs::msg::JointTrajectoryPoint;
+
+constexpr size_t kJoints = 7;
+constexpr std::chrono::milliseconds kPointSpacing{10};
+constexpr std::chrono::milliseconds kControlPeriod{1};
+
+/// Reports the allocations of the benchmark thread during its lifetime as allocs/op.
+class AllocationCounter
+{
+public:
+  explicit AllocationCounter(benchmark::State & state)
+  : state_(state), allocations_at_start_(thread_allocations)
+  {
+  }
+
+  ~AllocationCounter()
+  {
+    state_.counters["allocs/op"] = benchmark::Counter(
+      static_cast<double>(thread_allocations - allocations_at_start_),
+      benchmark::Counter::kAvgIterations);
+  }
+
+  AllocationCounter(const AllocationCounter &) = delete;
+  AllocationCounter & operator=(const AllocationCounter &) = delete;
+
+private:
+  benchmark::State & state_;
+  size_t allocations_at_start_;
+};
+
+/// Highest derivative of the points, selects the spline of interpolate_between_points()
+enum class Order
+{
+  kLinear,
+  kCubic,
+  kQuintic,
+};
+
+rclcpp::Time ros_time(std::chrono::nanoseconds time)
+{
+  // the clock type of the message stamps
+  return rclcpp::Time(time.count(), RCL_ROS_TIME);
+}
+
+JointTrajectoryPoint make_point(size_t index, Order order)
+{
+  JointTrajectoryPoint point;
+  point.time_from_start = rclcpp::Duration(static_cast<int64_t>(index) * kPointSpacing);
+  for (size_t joint = 0; joint < kJoints; ++joint)
+  {
+    const double phase = 0.01 * static_cast<double>(index) + static_cast<double>(joint);
+    point.positions.push_back(std::sin(phase));
+    if (order != Order::kLinear)
+    {
+      point.velocities.push_back(std::cos(phase));
+    }
+    if (order == Order::kQuintic)
+    {
+      point.accelerations.push_back(-std::sin(phase));
+    }
+  }
+  return point;
+}
+
+std::shared_ptr<JointTrajectory> make_trajectory_msg(size_t points, Order order)
+{
+  auto msg = std::make_shared<JointTrajectory>();
+  for (size_t joint = 0; joint < kJoints; ++joint)
+  {
+    msg->joint_names.push_back("joint" + std::to_string(joint + 1));
+  }
+  msg->points.reserve(points);
+  for (size_t i = 0; i < points; ++i)
+  {
+    // the first point is not at the start, so that sampling starts in the first segment
+    msg->points.push_back(make_point(i + 1, order));
+  }
+  return msg;
+}
+
+/// Sample points of a running trajectory, one control period apart, as the controller does.
+void BM_TrajectorySampleSequential(benchmark::State & state, bool resampled)
+{
+  const auto points = static_cast<size_t>(state.range(0));
+  const auto msg = make_trajectory_msg(points, Order::kQuintic);
+  msg->header.stamp = ros_time(std::chrono::seconds(1));
+  const rclcpp::Time start = msg->header.stamp;
+  const auto cycles = static_cast<int64_t>(points) * (kPointSpacing / kControlPeriod);
+
+  Trajectory trajectory(msg);
+  if (resampled)
+  {
+    trajectory.resample(rclcpp::Duration(kControlPeriod).nanoseconds());
+  }
+  JointTrajectoryPoint expected;
+  TrajectoryPointConstIter start_segment, end_segment;
+  trajectory.set_point_before_trajectory_msg(start, msg->points.front());
+  trajectory.sample(start, expected, start_segment, end_segment);
+
+  AllocationCounter allocations(state);
+  int64_t cycle = 0;
+  for (auto _ : state)
+  {
+    const rclcpp::Time time = start + rclcpp::Duration(cycle * kControlPeriod);
+    benchmark::DoNotOptimize(trajectory.sample(time, expected, start_segment, end_segment));
+    benchmark::ClobberMemory();
+    cycle = cycle + 1 < cycles ? cycle + 1 : 0;
+  }
+}
+BENCHMARK_CAPTURE(BM_TrajectorySampleSequential, splines, false)
+  ->RangeMultiplier(10)
+  ->Range(10, 100000);
+BENCHMARK_CAPTURE(BM_TrajectorySampleSequential, resampled, true)
+  ->RangeMultiplier(10)
+  ->Range(10, 100000);
+
+/// Sample points at random times, which needs a search for the segment unless it is resampled.
+void BM_TrajectorySampleRandom(benchmark::State & state, bool resampled)
+{
+  const auto points = static_cast<size_t>(state.range(0));
+  const auto msg = make_trajectory_msg(points, Order::kQuintic);
+  msg->header.stamp = ros_time(std::chrono::seconds(1));
+  const rclcpp::Time start = msg->header.stamp;
+  const std::chrono::nanoseconds duration = static_cast<int64_t>(points + 1) * kPointSpacing;
+
+  std::vector<rclcpp::Time> sample_times;
+  std::mt19937_64 generator(0);
+  std::uniform_int_distribution<int64_t> distribution(0, duration.count());
+  for (size_t i = 0; i < 1024; ++i)
+  {
+    sample_times.push_back(
+      start + rclcpp::Duration(std::chrono::nanoseconds(distribution(generator))));
+  }
+
+  Trajectory trajectory(msg);
+  if (resampled)
+  {
+    trajectory.resample(rclcpp::Duration(kControlPeriod).nanoseconds());
+  }
+  JointTrajectoryPoint expected;
+  TrajectoryPointConstIter start_segment, end_segment;
+  trajectory.set_point_before_trajectory_msg(start, msg->points.front());
+  trajectory.sample(start, expected, start_segment, end_segment);
+
+  AllocationCounter allocations(state);
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(
+      trajectory.sample(sample_times[i], expected, start_segment, end_segment));
+    benchmark::ClobberMemory();
+    i = (i + 1) % sample_times.size();
+  }
+}
+BENCHMARK_CAPTURE(BM_TrajectorySampleRandom, splines, false)
+  ->RangeMultiplier(10)
+  ->Range(10, 100000);
+BENCHMARK_CAPTURE(BM_TrajectorySampleRandom, resampled, true)
+  ->RangeMultiplier(10)
+  ->Range(10, 100000);
+
+void BM_InterpolateBetweenPoints(benchmark::State & state, Order order)
+{
+  const JointTrajectoryPoint point_a = make_point(0, order);
+  const JointTrajectoryPoint point_b = make_point(1, order);
+  const rclcpp::Time time_a = ros_time(std::chrono::seconds(1));
+  const rclcpp::Time time_b = time_a + rclcpp::Duration(kPointSpacing);
+  const rclcpp::Time sample_time = time_a + rclcpp::Duration(kPointSpacing / 3);
+
+  Trajectory trajectory;
+  JointTrajectoryPoint output;
+  trajectory.interpolate_between_points(time_a, point_a, time_b, point_b, sample_time, output);
+
+  AllocationCounter allocations(state);
+  for (auto _ : state)
+  {
+    trajectory.interpolate_between_points(time_a, point_a, time_b, point_b, sample_time, output);
+    benchmark::DoNotOptimize(output.positions.data());
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK_CAPTURE(BM_InterpolateBetweenPoints, linear, Order::kLinear);
+BENCHMARK_CAPTURE(BM_InterpolateBetweenPoints, cubic, Order::kCubic);
+BENCHMARK_CAPTURE(BM_InterpolateBetweenPoints, quintic, Order::kQuintic);
+
+/// Exposes the protected method to hand over a trajectory without a subscriber.
+class BenchmarkedController : public JointTrajectoryController
+{
+public:
+  using JointTrajectoryController::add_new_trajectory_msg;
+};
+
+/// update() of an active effort controller following a long trajectory, with interfaces on plain
+/// variables instead of a hardware.
+void BM_ControllerUpdate(benchmark::State & state)
+{
+  std::vector<std::string> joint_names;
+  for (size_t joint = 0; joint < kJoints; ++joint)
+  {
+    joint_names.push_back("joint" + std::to_string(joint + 1));
+  }
+  std::vector<double> positions(kJoints, 0.0);
+  std::vector<double> velocities(kJoints, 0.0);
+  std::vector<double> efforts(kJoints, 0.0);
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+  std::vector<hardware_interface::CommandInterface> command_interfaces;
+  for (size_t joint = 0; joint < kJoints; ++joint)
+  {
+    state_interfaces.emplace_back(
+      joint_names[joint], hardware_interface::HW_IF_POSITION, &positions[joint]);
+    state_interfaces.emplace_back(
+      joint_names[joint], hardware_interface::HW_IF_VELOCITY, &velocities[joint]);
+    command_interfaces.emplace_back(
+      joint_names[joint], hardware_interface::HW_IF_EFFORT, &efforts[joint]);
+  }
+
+  BenchmarkedController controller;
+  if (controller.init("benchmarked_controller") != controller_interface::return_type::OK)
+  {
+    state.SkipWithError("Could not initialize the controller");
+    return;
+  }
+  const auto node = controller.get_node();
+  node->set_parameter(rclcpp::Parameter("joints", joint_names));
+  node->set_parameter(
+    rclcpp::Parameter("command_interfaces", std::vector<std::string>{"effort"}));
+  node->set_parameter(
+    rclcpp::Parameter("state_interfaces", std::vector<std::string>{"position", "velocity"}));
+  node->configure();
+  for (const auto & joint_name : joint_names)
+  {
+    node->set_parameter(rclcpp::Parameter("gains." + joint_name + ".p", 100.0));
+    node->set_parameter(rclcpp::Parameter("gains." + joint_name + ".d", 10.0));
+  }
+
+  std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+  for (auto & interface : state_interfaces)
+  {
+    loaned_state_interfaces.emplace_back(interface);
+  }
+  std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+  for (auto & interface : command_interfaces)
+  {
+    loaned_command_interfaces.emplace_back(interface);
+  }
+  controller.assign_interfaces(
+    std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+  if (node->activate().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+  {
+    state.SkipWithError("Could not activate the controller");
+    return;
+  }
+
+  constexpr size_t kPoints = 1000;
+  controller.add_new_trajectory_msg(make_trajectory_msg(kPoints, Order::kQuintic));
+  const rclcpp::Time start = ros_time(std::chrono::seconds(1));
+  const rclcpp::Duration period(kControlPeriod);
+  // restart before the end, which would finish the trajectory and hold the position
+  const int64_t cycles = static_cast<int64_t>(kPoints) * (kPointSpacing / kControlPeriod) - 1;
+  controller.update(start, period);
+
+  AllocationCounter allocations(state);
+  int64_t cycle = 1;
+  for (auto _ : state)
+  {
+    controller.update(start + rclcpp::Duration(cycle * kControlPeriod), period);
+    benchmark::ClobberMemory();
+    cycle = cycle + 1 < cycles ? cycle + 1 : 1;
+  }
+}
+BENCHMARK(BM_ControllerUpdate);
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  benchmark::Initialize(&argc, argv);
+  rclcpp::init(argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__BATCHED_PID_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__BATCHED_PID_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief PID gains of all joints at the breakpoints of a scheduling variable.
+ *
+ * Between two breakpoints the gains are interpolated linearly, outside of the breakpoints the
+ * gains of the first or last one are used. A schedule with a single breakpoint has constant gains.
+ * The gains have the meaning of control_toolbox::Pid(p, i, d, i_clamp, -i_clamp).
+ */
+struct GainSchedule
+{
+  /// Values of the scheduling variable, ascending and not empty.
+  std::vector<double> breakpoints;
+  /// One vector with the gains of all joints per breakpoint.
+  std::vector<Eigen::VectorXd> p, i, d, i_clamp;
+  /// Not scheduled.
+  Eigen::VectorXd velocity_ff;
+};
+
+/**
+ * \brief PID controller for all joints, with gains and integrators in contiguous vectors.
+ *
+ * Computes the same command per joint as control_toolbox::Pid without anti-windup plus the
+ * velocity feed-forward of JointTrajectoryController. Joints is the number of joints or
+ * Eigen::Dynamic, all points passed in have to have the size given to resize().
+ */
+template <int Joints>
+class BatchedPid
+{
+public:
+  using Vector = Eigen::Matrix<double, Joints, 1>;
+  using Point = trajectory_msgs::msg::JointTrajectoryPoint;
+
+  /// Allocates the storage for size joints and clears the gains. Not realtime safe.
+  void resize(size_t size)
+  {
+    const auto rows = static_cast<Eigen::Index>(size);
+    for (Vector * vector :
+         {&p_gain_, &i_gain_, &d_gain_, &i_max_, &i_min_, &velocity_ff_, &i_error_, &error_,
+          &error_dot_, &pid_, &command_})
+    {
+      vector->setZero(rows);
+    }
+  }
+
+  /// Clear the integrators.
+  void reset() { i_error_.setZero(); }
+
+  /// Take the gains of schedule at the given value of the scheduling variable. Realtime safe.
+  void set_gains(const GainSchedule & schedule, double variable)
+  {
+    const auto & breakpoints = schedule.breakpoints;
+    // first breakpoint after variable, the segment before it is interpolated
+    const size_t upper = static_cast<size_t>(
+      std::upper_bound(breakpoints.begin(), breakpoints.end(), variable) - breakpoints.begin());
+    if (upper == 0 || upper == breakpoints.size())
+    {
+      const size_t index = upper == 0 ? 0 : breakpoints.size() - 1;
+      p_gain_ = schedule.p[index];
+      i_gain_ = schedule.i[index];
+      d_gain_ = schedule.d[index];
+      i_max_ = schedule.i_clamp[index];
+    }
+    else
+    {
+      const size_t lower = upper - 1;
+      const double weight =
+        (variable - breakpoints[lower]) / (breakpoints[upper] - breakpoints[lower]);
+      p_gain_ = schedule.p[lower] + weight * (schedule.p[upper] - schedule.p[lower]);
+      i_gain_ = schedule.i[lower] + weight * (schedule.i[upper] - schedule.i[lower]);
+      d_gain_ = schedule.d[lower] + weight * (schedule.d[upper] - schedule.d[lower]);
+      i_max_ =
+        schedule.i_clamp[lower] + weight * (schedule.i_clamp[upper] - schedule.i_clamp[lower]);
+    }
+    i_min_ = -i_max_;
+    velocity_ff_ = schedule.velocity_ff;
+  }
+
+  /**
+   * \brief PID command on the position and velocity error plus velocity and effort feed-forward.
+   * Like control_toolbox::Pid, joints with a non-finite error and all joints for dt_ns == 0
+   * get no PID term and do not integrate.
+   * \param feedforward effort added to the command, may be empty.
+   * \return command for all joints, valid until the next call
+   */
+  const Vector & compute_effort(
+    const Point & desired, const Point & current, uint64_t dt_ns,
+    const std::vector<double> & feedforward)
+  {
+    command_.noalias() = velocity_ff_.cwiseProduct(map(desired.velocities));
+    if (!feedforward.empty())
+    {
+      command_ += map(feedforward);
+    }
+    if (dt_ns == 0)
+    {
+      return command_;
+    }
+
+    // members instead of temporaries, so that Eigen::Dynamic does not allocate
+    error_.noalias() = map(desired.positions) - map(current.positions);
+    error_dot_.noalias() = map(desired.velocities) - map(current.velocities);
+    const auto valid = error_.array().isFinite() && error_dot_.array().isFinite();
+
+    const double dt = static_cast<double>(dt_ns) / 1e9;
+    i_error_ = valid.select(i_error_ + dt * error_, i_error_);
+    pid_.noalias() = p_gain_.cwiseProduct(error_) +
+                     i_gain_.cwiseProduct(i_error_).cwiseMin(i_max_).cwiseMax(i_min_) +
+                     d_gain_.cwiseProduct(error_dot_);
+    command_ += valid.select(pid_, Vector::Zero(pid_.size()));
+    return command_;
+  }
+
+private:
+  Eigen::Map<const Vector> map(const std::vector<double> & values) const
+  {
+    return Eigen::Map<const Vector>(values.data(), command_.size());
+  }
+
+  Vector p_gain_;
+  Vector i_gain_;
+  Vector d_gain_;
+  Vector i_max_;
+  Vector i_min_;
+  Vector velocity_ff_;
+  Vector i_error_;
+  Vector error_;
+  Vector error_dot_;
+  Vector pid_;
+  Vector command_;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__BATCHED_PID_HPP_
@@ -0,0 +1,121 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__FIXED_SIZE_CORE_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__FIXED_SIZE_CORE_HPP_
+
+#include <cmath>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "joint_effort_trajectory_controller/tolerances.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/// Number of joints for which JointTrajectoryController uses FixedSizeCore, the Panda arm.
+constexpr size_t kFixedSizeJoints = 7;
+
+/**
+ * \brief Error and tolerance check for a compile-time number of joints.
+ *
+ * Computes the same values as the per joint code of JointTrajectoryController, i.e.
+ * angles::shortest_angular_distance() and check_state_tolerance_per_joint(), but for all
+ * joints at once on fixed-size Eigen vectors. The PID command is computed by BatchedPid.
+ * The vectors of all points passed in have to have exactly Joints entries (or none, where noted).
+ */
+template <int Joints>
+class FixedSizeCore
+{
+public:
+  using Vector = Eigen::Matrix<double, Joints, 1>;
+  using Point = trajectory_msgs::msg::JointTrajectoryPoint;
+
+  void set_tolerances(const SegmentTolerances & tolerances)
+  {
+    for (int joint = 0; joint < Joints; ++joint)
+    {
+      state_tolerance_.col(joint) = to_vector(tolerances.state_tolerance[joint]);
+      goal_state_tolerance_.col(joint) = to_vector(tolerances.goal_state_tolerance[joint]);
+    }
+  }
+
+  /**
+   * \brief Error between desired and current state, positions as shortest angular distance.
+   * \param velocity_error, acceleration_error whether error.velocities/accelerations are set.
+   */
+  void compute_error(
+    const Point & current, const Point & desired, bool velocity_error, bool acceleration_error,
+    Point & error) const
+  {
+    constexpr double kTwoPi = 2.0 * M_PI;
+    const Vector difference = map(desired.positions) - map(current.positions);
+    map(error.positions) = difference - kTwoPi * (difference / kTwoPi).array().round().matrix();
+    if (velocity_error)
+    {
+      map(error.velocities) = map(desired.velocities) - map(current.velocities);
+    }
+    if (acceleration_error)
+    {
+      map(error.accelerations) = map(desired.accelerations) - map(current.accelerations);
+    }
+  }
+
+  /// Check error against the state tolerances, or the goal tolerances if goal is set.
+  /// error.velocities and error.accelerations may be empty.
+  bool within_tolerance(const Point & error, bool goal) const
+  {
+    const auto & tolerance = goal ? goal_state_tolerance_ : state_tolerance_;
+    Tolerances magnitude = Tolerances::Zero();
+    magnitude.row(0) = map(error.positions).cwiseAbs().transpose();
+    if (!error.velocities.empty())
+    {
+      magnitude.row(1) = map(error.velocities).cwiseAbs().transpose();
+    }
+    if (!error.accelerations.empty())
+    {
+      magnitude.row(2) = map(error.accelerations).cwiseAbs().transpose();
+    }
+    // a tolerance of zero is not checked
+    return !((tolerance.array() > 0.0) && (magnitude.array() > tolerance.array())).any();
+  }
+
+private:
+  /// position, velocity and acceleration rows, one column per joint. Not aligned, so that
+  /// the class can be a member without aligned allocation.
+  using Tolerances = Eigen::Matrix<double, 3, Joints, Eigen::DontAlign>;
+
+  static Eigen::Map<Vector> map(std::vector<double> & values)
+  {
+    return Eigen::Map<Vector>(values.data());
+  }
+
+  static Eigen::Map<const Vector> map(const std::vector<double> & values)
+  {
+    return Eigen::Map<const Vector>(values.data());
+  }
+
+  static Eigen::Vector3d to_vector(const StateTolerances & tolerance)
+  {
+    return Eigen::Vector3d(tolerance.position, tolerance.velocity, tolerance.acceleration);
+  }
+
+  Tolerances state_tolerance_ = Tolerances::Zero();
+  Tolerances goal_state_tolerance_ = Tolerances::Zero();
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__FIXED_SIZE_CORE_HPP_
@@ -15,6 +15,8 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__JOINT_TRAJECTORY_CONTROLLER_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__JOINT_TRAJECTORY_CONTROLLER_HPP_
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <mutex>
@@ -24,12 +26,14 @@
 
 #include "control_msgs/action/follow_joint_trajectory.hpp"
 #include "control_msgs/msg/joint_trajectory_controller_state.hpp"
-#include "control_toolbox/pid.hpp"
+#include "batched_pid.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "fixed_size_core.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "tolerances.hpp"
 #include "visibility_control.h"
 #include "rclcpp/duration.hpp"
+#include "rclcpp/node_interfaces/node_parameters_interface.hpp"
 #include "rclcpp/subscription.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp/timer.hpp"
@@ -123,7 +127,23 @@ protected:
   /// Run he controller in open-loop, i.e., read hardware states only when starting controller.
   /// This is useful when robot is not exactly following the commanded trajectory.
   bool open_loop_control_ = false;
+  /// Merge the points of new messages on the topic into the active trajectory instead of
+  /// replacing it, see splice_trajectory_msg().
+  bool trajectory_append_mode_ = false;
+  /// If > 0, the splines of new trajectories are resampled with this period before update()
+  /// samples them, see Trajectory::resample().
+  int64_t resample_period_ns_ = 0;
+  /// Velocity and acceleration limits of every joint, 0 for no limit. Trajectories which exceed
+  /// them are rejected, or slowed down if scale_trajectories_ is set.
+  std::vector<double> max_velocities_;
+  std::vector<double> max_accelerations_;
+  bool has_trajectory_limits_ = false;
+  bool scale_trajectories_ = false;
   trajectory_msgs::msg::JointTrajectoryPoint last_commanded_state_;
+  /// Copy of last_commanded_state_.positions for the callbacks, which hold joints at these
+  /// positions. update() only copies into it when it gets hold_positions_mutex_ without waiting.
+  std::vector<double> hold_positions_;
+  mutable std::mutex hold_positions_mutex_;
 
   // The interfaces are defined as the types in 'allowed_interface_types_' member.
   // For convenience, for each type the interfaces are ordered so that i-th position
@@ -143,9 +163,29 @@ protected:
 
   /// If true, a velocity feedforward term plus corrective PID term is used
   bool use_closed_loop_pid_adapter = false;
-  std::vector<std::unique_ptr<control_toolbox::Pid>> pids_;
-  std::chrono::steady_clock::time_point last_update_time_;
-  std::vector<double> velocity_ff_;
+  /// PID of all joints; fixed_size_pid_ is used instead of pid_ for kFixedSizeJoints joints
+  BatchedPid<Eigen::Dynamic> pid_;
+  BatchedPid<kFixedSizeJoints> fixed_size_pid_;
+  /// Gains from the 'gains', 'velocity_ff' and 'gain_schedule' parameters, replaced as a whole by
+  /// on_set_gain_parameters(). The buffer releases the previous schedule on the non-realtime side.
+  realtime_tools::RealtimeBuffer<std::shared_ptr<const GainSchedule>> gain_schedule_;
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr gain_parameters_handle_;
+  /// Full name of the state interface the gains are scheduled on, empty for constant gains
+  std::string gain_schedule_interface_name_;
+  const hardware_interface::LoanedStateInterface * gain_schedule_interface_ = nullptr;
+  /// Add the 'gravity' and/or 'coriolis' state interfaces of the joints to the effort command
+  bool feedforward_gravity_ = false;
+  bool feedforward_coriolis_ = false;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    gravity_state_interface_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    coriolis_state_interface_;
+  /// Sum of the feed-forward interfaces, empty without feed-forward
+  std::vector<double> feedforward_effort_;
+  /// For kFixedSizeJoints joints, error and tolerances are computed by fixed_size_core_
+  /// instead of the per joint code.
+  bool use_fixed_size_core_ = false;
+  FixedSizeCore<kFixedSizeJoints> fixed_size_core_;
 
   // TODO(karsten1987): eventually activate and deactivate subscriber directly when its supported
   bool subscriber_is_active_ = false;
@@ -156,8 +196,20 @@ protected:
   std::shared_ptr<Trajectory> traj_external_point_ptr_ = nullptr;
   std::shared_ptr<Trajectory> traj_home_point_ptr_ = nullptr;
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> traj_msg_home_ptr_ = nullptr;
-  realtime_tools::RealtimeBuffer<std::shared_ptr<trajectory_msgs::msg::JointTrajectory>>
-    traj_msg_external_point_ptr_;
+  /// Trajectory handed from add_new_trajectory_msg() to update(). The trajectory is built
+  /// completely on the non-realtime side, update() only samples it.
+  struct PreparedTrajectory
+  {
+    std::shared_ptr<Trajectory> trajectory;
+    /// The trajectory which trajectory continues, if it was spliced
+    std::shared_ptr<Trajectory> spliced_onto;
+  };
+  /// After update() took a trajectory, the buffer holds the previous one until the next write,
+  /// so that trajectories are always released on the non-realtime side.
+  realtime_tools::RealtimeBuffer<PreparedTrajectory> traj_msg_external_point_ptr_;
+  /// Last trajectory given to update(), guarded by prepared_msg_mutex_. Non-realtime only.
+  std::shared_ptr<Trajectory> last_prepared_trajectory_;
+  std::mutex prepared_msg_mutex_;
 
   // The controller should be in halted state after creation otherwise memory corruption
   // TODO(anyone): Is the variable relevant, since we are using lifecycle?
@@ -171,6 +223,10 @@ protected:
 
   rclcpp::Duration state_publisher_period_ = rclcpp::Duration(20ms);
   rclcpp::Time last_state_publish_time_;
+  /// If > 0, the state is published every state_publish_decimation_ updates instead of
+  /// state_publisher_period_
+  int state_publish_decimation_ = 0;
+  int state_publish_ticks_ = 0;
 
   using FollowJTrajAction = control_msgs::action::FollowJointTrajectory;
   using RealtimeGoalHandle = realtime_tools::RealtimeServerGoalHandle<FollowJTrajAction>;
@@ -181,6 +237,15 @@ protected:
   bool allow_partial_joints_goal_ = false;
   RealtimeGoalHandleBuffer rt_active_goal_;  ///< Currently active action goal, if any.
   rclcpp::TimerBase::SharedPtr goal_handle_timer_;
+  /// Goal which update() has finished, the result is reported by the goal timer.
+  std::atomic<RealtimeGoalHandle *> finished_goal_{nullptr};
+  /// Owns finished_goal_. Set by update() while finished_goal_ is null, moved out by
+  /// report_finished_goal() before it resets finished_goal_, so that update() never releases it.
+  RealtimeGoalHandlePtr finished_goal_owner_;
+  /// Last goal handed over by report_finished_goal(), keeps rt_finished_goal_ from being reused.
+  RealtimeGoalHandlePtr reported_goal_;
+  /// Last goal finished by update(), only used from the realtime thread.
+  const RealtimeGoalHandle * rt_finished_goal_ = nullptr;
   rclcpp::Duration action_monitor_period_ = rclcpp::Duration(50ms);
 
   // callbacks for action_server_
@@ -194,8 +259,20 @@ protected:
   void feedback_setup_callback(
     std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
 
+  /// Stores the result of a goal and hands the goal over to the goal timer. Realtime safe.
+  /// Does nothing while the previously finished goal is not taken yet, update() retries then.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void finish_goal(const RealtimeGoalHandlePtr & goal, int32_t error_code);
+  /// Hands the feedback filled by update(), if any, to goal. Not realtime safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void take_ready_feedback(const RealtimeGoalHandlePtr & goal);
+  /// Sends the result of goal if update() has finished it. Takes a different finished goal
+  /// without reporting it, that goal was canceled or preempted already. Not realtime safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void report_finished_goal(const RealtimeGoalHandlePtr & goal);
+
   // fill trajectory_msg so it matches joints controlled by this controller
-  // positions set to current position, velocities, accelerations and efforts to 0.0
+  // positions set to hold_positions_, velocities, accelerations and efforts to 0.0
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void fill_partial_goal(
     std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg) const;
@@ -205,9 +282,32 @@ protected:
     std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg);
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool validate_trajectory_msg(const trajectory_msgs::msg::JointTrajectory & trajectory) const;
+  /// \return the factor by which the time of a validated trajectory has to be stretched to stay
+  /// within max_velocities_ and max_accelerations_, see compute_time_scale(). Not realtime safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  double compute_trajectory_time_scale(
+    const trajectory_msgs::msg::JointTrajectory & trajectory, size_t & limiting_joint) const;
+  /// \param[out] time_scale factor for add_new_trajectory_msg(), 1 if there is no limit
+  /// \return false if a validated trajectory exceeds the joint limits and may not be slowed down
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool check_trajectory_limits(
+    const trajectory_msgs::msg::JointTrajectory & trajectory, double & time_scale) const;
+  /// Completes and sorts traj_msg and hands a trajectory made from it to update(). With append,
+  /// the message is spliced into the active trajectory. A time_scale above 1 from
+  /// check_trajectory_limits() slows the new points down. Not realtime safe.
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void add_new_trajectory_msg(
-    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg);
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg, bool append = false,
+    double time_scale = 1.0);
+  /// Replaces msg by the active trajectory up to now, followed by the points of msg after now.
+  /// If the active trajectory has started, its sampled state at now becomes the first point.
+  /// The result keeps the header.stamp of active_msg. Both messages have to be in the local
+  /// joint order.
+  /// \return false if no point of msg lies after now
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool splice_trajectory_msg(
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & active_msg,
+    const rclcpp::Time & now, trajectory_msgs::msg::JointTrajectory & msg) const;
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool validate_trajectory_point_field(
     size_t joint_names_size, const std::vector<double> & vector_field,
@@ -223,16 +323,45 @@ protected:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool reset();
 
+  /**
+   * \brief Build the gain schedule of all joints from the parameters.
+   * \param overrides parameters which are about to be set, taken instead of the current values.
+   * \param[out] error reason if the parameters are invalid.
+   * \return the schedule, nullptr if the parameters are invalid.
+   */
+  std::shared_ptr<const GainSchedule> make_gain_schedule(
+    const std::vector<rclcpp::Parameter> & overrides, std::string & error) const;
+  rcl_interfaces::msg::SetParametersResult on_set_gain_parameters(
+    const std::vector<rclcpp::Parameter> & parameters);
+
   using JointTrajectoryPoint = trajectory_msgs::msg::JointTrajectoryPoint;
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void publish_state(
-    const JointTrajectoryPoint & desired_state, const JointTrajectoryPoint & current_state,
+    const rclcpp::Time & time, const JointTrajectoryPoint & desired_state, const JointTrajectoryPoint & current_state,
     const JointTrajectoryPoint & state_error);
 
   void read_state_from_hardware(JointTrajectoryPoint & state);
 
   bool read_state_from_command_interfaces(JointTrajectoryPoint & state);
 
+  // Working storage of update(), sized in on_configure() so that no tick has to allocate
+  JointTrajectoryPoint state_current_;
+  JointTrajectoryPoint state_desired_;
+  JointTrajectoryPoint state_error_;
+  /// Feedback messages for the active goal, update() alternates between them. update() only
+  /// fills one while ready_feedback_ is null. The goal timer takes the buffer out of
+  /// ready_feedback_ and publishes it before it takes the next one, so update() never rewrites
+  /// a buffer which is being published.
+  std::array<std::shared_ptr<FollowJTrajAction::Feedback>, 2> feedback_buffers_;
+  size_t feedback_buffer_index_ = 0;
+  /// Feedback filled by update() and not yet taken by the goal timer.
+  std::atomic<FollowJTrajAction::Feedback *> ready_feedback_{nullptr};
+  /// Feedback is filled at most every action_feedback_period_. feedback_goal_ is the goal which
+  /// got the last feedback, only compared and never dereferenced.
+  rclcpp::Duration action_feedback_period_ = rclcpp::Duration(50ms);
+  rclcpp::Time last_feedback_time_;
+  const RealtimeGoalHandle * feedback_goal_ = nullptr;
+
 private:
   bool contains_interface_type(
     const std::vector<std::string> & interface_type_list, const std::string & interface_type);
@@ -0,0 +1,58 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__REALTIME_ALLOCATION_CHECK_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__REALTIME_ALLOCATION_CHECK_HPP_
+
+namespace joint_trajectory_controller
+{
+#ifdef CHECK_RT_ALLOCATIONS
+
+/// Enables or disables the allocation check for the calling thread.
+/// \return whether the check was enabled before
+bool set_allocation_check(bool enabled);
+
+/// Scope in which the calling thread aborts on malloc(), calloc(), realloc(), the aligned
+/// variants, free() and operator delete. A nested guard with forbid == false allows them again
+/// for its scope. The check only sees them if
+/// libjoint_effort_trajectory_controller_allocation_check.so is preloaded with LD_PRELOAD.
+class RealtimeAllocationGuard
+{
+public:
+  explicit RealtimeAllocationGuard(bool forbid = true) : previous_(set_allocation_check(forbid)) {}
+  ~RealtimeAllocationGuard() { set_allocation_check(previous_); }
+
+  RealtimeAllocationGuard(const RealtimeAllocationGuard &) = delete;
+  RealtimeAllocationGuard & operator=(const RealtimeAllocationGuard &) = delete;
+
+private:
+  bool previous_;
+};
+
+#else
+
+/// Does nothing unless the package is built with CHECK_RT_ALLOCATIONS=ON.
+class RealtimeAllocationGuard
+{
+public:
+  explicit RealtimeAllocationGuard(bool /*forbid*/ = true) {}
+
+  RealtimeAllocationGuard(const RealtimeAllocationGuard &) = delete;
+  RealtimeAllocationGuard & operator=(const RealtimeAllocationGuard &) = delete;
+};
+
+#endif  // CHECK_RT_ALLOCATIONS
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__REALTIME_ALLOCATION_CHECK_HPP_
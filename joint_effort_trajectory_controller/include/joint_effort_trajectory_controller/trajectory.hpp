@@ -15,6 +15,7 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -55,6 +56,28 @@ public:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory);
 
+  /// Take over the sampling state of the trajectory which this one continues. Both trajectories
+  /// need the same, non zero header.stamp. Realtime safe if both have the same number of joints.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void continue_from(const Trajectory & previous);
+
+  /// Resample the splines of all segments onto a uniform grid. Not realtime safe.
+  /**
+   * Afterwards sample() interpolates linearly between the two grid samples around the sample time
+   * instead of evaluating the spline of its segment, so trajectories with many short segments
+   * cost the same per sample as those with few long ones. The grid covers the points of the
+   * message, the segment from the point before the trajectory is still evaluated as a spline.
+   * Replacing the message with update() drops the grid.
+   * \param[in] period_ns Time between two samples in nanoseconds.
+   * \return false if the trajectory has less than two points or the grid would have more than
+   * kMaxResampledSamples samples. sample() then keeps evaluating the splines.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool resample(int64_t period_ns);
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool is_resampled() const { return grid_period_ns_ > 0; }
+
   /// Find the segment (made up of 2 points) and its expected state from the
   /// containing trajectory.
   /**
@@ -69,6 +92,9 @@ public:
   *    start_segment_itr = --end(), end_segment_itr = end()
   * - Sampling empty msg or before the time given in set_point_before_trajectory_msg()
   *    return false
+  *
+  * \p expected_state is only written if true is returned. Its vectors are resized only if their
+  * size does not match, so sampling into a preallocated point does not allocate.
   */
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool sample(
@@ -93,6 +119,10 @@ public:
    * \param[in] state_b State at time \p time_b.
    * \param[in] sample_time The time to sample, between time_a and time_b.
    * \param[out] output The state at \p sample_time.
+   *
+   * Computes the spline coefficients of the two states on every call, into a buffer of the
+   * trajectory which only allocates when it has to grow. sample() uses the coefficients
+   * precomputed for the segments of the trajectory instead.
    */
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void interpolate_between_points(
@@ -125,15 +155,123 @@ public:
   bool is_sampled_already() const { return sampled_already_; }
 
 private:
+  /// Caches the point times and the spline coefficients of all segments of trajectory_msg_.
+  void preprocess();
+
+  /// Find the index of the segment [i, i + 1] which contains \p time_from_start_ns.
+  /**
+   * The segment of the previous call and its successor are checked first, so sampling with
+   * monotonically increasing time is O(1). Otherwise a binary search is used.
+   * \return The index i or the index of the last point if \p time_from_start_ns is after it.
+   * Requires time_from_start_ns >= time of the first point.
+   */
+  size_t find_segment(int64_t time_from_start_ns);
+
+  /// Interpolate the grid of resample() at \p time_from_start_ns.
+  /**
+   * Requires a time between the first and the last point.
+   * \return The index of the segment which contains \p time_from_start_ns.
+   */
+  size_t sample_grid(
+    int64_t time_from_start_ns, trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg_;
   rclcpp::Time trajectory_start_time_;
 
+  /// time_from_start of every point in nanoseconds
+  std::vector<int64_t> point_times_ns_;
+  /// segment found in the previous call of sample()
+  size_t segment_cursor_ = 0;
+
+  /// number of joints in trajectory_msg_
+  size_t dim_ = 0;
+  /// kSplineCoefficients x dim_ coefficients per segment, see compute_spline_coefficients()
+  std::vector<double> segment_coefficients_;
+  /// coefficients of the segment from state_before_traj_msg_ to the first point
+  std::vector<double> first_segment_coefficients_;
+  /// scratch storage of interpolate_between_points(), at least kSplineCoefficients x dim_
+  std::vector<double> interpolation_coefficients_;
+  bool first_segment_ready_ = false;
+
+  /// time between two samples of grid_, 0 if the trajectory is not resampled
+  int64_t grid_period_ns_ = 0;
+  /// positions, velocities and accelerations of all joints, 3 x dim_ values per sample. The
+  /// samples are grid_period_ns_ apart from the first point on, the last one is at the last point.
+  std::vector<double> grid_;
+  /// index of the segment which contains each sample
+  std::vector<uint32_t> grid_segments_;
+
   rclcpp::Time time_before_traj_msg_;
   trajectory_msgs::msg::JointTrajectoryPoint state_before_traj_msg_;
 
   bool sampled_already_ = false;
 };
 
+/// Number of polynomial coefficients stored per joint and segment (quintic spline).
+constexpr size_t kSplineCoefficients = 6;
+
+/// Upper bound of the samples of Trajectory::resample(), about 17 minutes at 1 kHz.
+constexpr size_t kMaxResampledSamples = 1000000;
+
+/**
+ * Computes the polynomial coefficients of the spline segment from \p state_a to \p state_b.
+ *
+ * The order is chosen as described in Trajectory::interpolate_between_points(). Unused higher
+ * order coefficients are zero.
+ *
+ * \param[in] state_a State at the start of the segment.
+ * \param[in] state_b State at the end of the segment.
+ * \param[in] duration Duration of the segment in seconds.
+ * \param[in] allow_higher_order If false, a linear interpolation is used in any case.
+ * \param[out] coefficients kSplineCoefficients x dim values, stored order by order, each order
+ * holding the contiguous values of all joints.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void compute_spline_coefficients(
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_b, double duration,
+  bool allow_higher_order, double * coefficients);
+
+/**
+ * Evaluates position, velocity and acceleration of a spline segment.
+ *
+ * \param[in] coefficients Coefficients as computed by compute_spline_coefficients().
+ * \param[in] dim Number of joints.
+ * \param[in] t Time since the start of the segment in seconds.
+ * \param[out] output The state at \p t.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void evaluate_spline(
+  const double * coefficients, size_t dim, double t,
+  trajectory_msgs::msg::JointTrajectoryPoint & output);
+
+/**
+ * Computes by how much the time of a trajectory has to be stretched, so that its splines stay
+ * within velocity and acceleration limits.
+ *
+ * Stretching the time by a factor s divides the velocities by s and the accelerations by s^2,
+ * see scale_trajectory_time(). Only the splines between the points of \p trajectory are checked,
+ * not the segment from the state before the trajectory or the velocity steps between linear
+ * segments.
+ *
+ * \param[in] trajectory Trajectory whose point times are strictly increasing.
+ * \param[in] max_velocities Velocity limit of every joint of \p trajectory, 0 for no limit.
+ * \param[in] max_accelerations Acceleration limit of every joint of \p trajectory, 0 for no limit.
+ * \param[in] step_ns The splines are checked at the points and every \p step_ns in between.
+ * \param[out] limiting_joint Index of the joint which needs the largest factor.
+ * \return The factor, 1 if the trajectory is within the limits.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+double compute_time_scale(
+  const trajectory_msgs::msg::JointTrajectory & trajectory,
+  const std::vector<double> & max_velocities, const std::vector<double> & max_accelerations,
+  int64_t step_ns, size_t & limiting_joint);
+
+/// Stretch the time of all points of \p trajectory by \p scale and slow down their velocities
+/// and accelerations accordingly, so that it follows the same path.
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void scale_trajectory_time(trajectory_msgs::msg::JointTrajectory & trajectory, double scale);
+
 /**
  * \return The map between \p t1 indices (implicitly encoded in return vector indices) to \p t2 indices.
  * If \p t1 is <tt>"{C, B}"</tt> and \p t2 is <tt>"{A, B, C, D}"</tt>, the associated mapping vector is
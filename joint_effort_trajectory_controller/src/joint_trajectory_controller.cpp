@@ -15,6 +15,7 @@
 #include "joint_effort_trajectory_controller/joint_trajectory_controller.hpp"
 
 #include <stddef.h>
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -28,8 +29,10 @@
 #include "builtin_interfaces/msg/time.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_effort_trajectory_controller/realtime_allocation_check.hpp"
 #include "joint_effort_trajectory_controller/trajectory.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/exceptions.hpp"
 #include "rclcpp/logging.hpp"
 #include "rclcpp/parameter.hpp"
 #include "rclcpp/qos.hpp"
@@ -59,9 +62,18 @@ CallbackReturn JointTrajectoryController::on_init()
     auto_declare<std::vector<std::string>>("command_interfaces", command_interface_types_);
     auto_declare<std::vector<std::string>>("state_interfaces", state_interface_types_);
     auto_declare<double>("state_publish_rate", 50.0);
+    auto_declare<int>("state_publish_decimation", 0);
     auto_declare<double>("action_monitor_rate", 20.0);
+    auto_declare<double>("action_feedback_rate", 0.0);
     auto_declare<bool>("allow_partial_joints_goal", allow_partial_joints_goal_);
     auto_declare<bool>("open_loop_control", open_loop_control_);
+    auto_declare<bool>("trajectory_append_mode", trajectory_append_mode_);
+    auto_declare<double>("resample_period", 0.0);
+    auto_declare<bool>("limits.scale_trajectories", scale_trajectories_);
+    auto_declare<std::string>("gain_schedule.interface", "");
+    auto_declare<std::vector<double>>("gain_schedule.breakpoints", std::vector<double>());
+    auto_declare<bool>("feedforward.gravity", feedforward_gravity_);
+    auto_declare<bool>("feedforward.coriolis", feedforward_coriolis_);
     auto_declare<double>("constraints.stopped_velocity_tolerance", 0.01);
     auto_declare<double>("constraints.goal_time", 0.0);
     for (const auto & joint_name : joint_names_)
@@ -108,12 +120,27 @@ JointTrajectoryController::state_interface_configuration() const
     {
       conf.names.push_back(joint_name + "/" + interface_type);
     }
+    if (feedforward_gravity_)
+    {
+      conf.names.push_back(joint_name + "/gravity");
+    }
+    if (feedforward_coriolis_)
+    {
+      conf.names.push_back(joint_name + "/coriolis");
+    }
+  }
+  if (
+    !gain_schedule_interface_name_.empty() &&
+    std::find(conf.names.begin(), conf.names.end(), gain_schedule_interface_name_) ==
+      conf.names.end())
+  {
+    conf.names.push_back(gain_schedule_interface_name_);
   }
   return conf;
 }
 
 controller_interface::return_type JointTrajectoryController::update(
-    const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+    const rclcpp::Time & time, const rclcpp::Duration & period)
 {
   if (get_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
   {
@@ -137,19 +164,21 @@ controller_interface::return_type JointTrajectoryController::update(
     }
   };
 
-  // Check if a new external message has been received from nonRT threads
-  auto current_external_msg = traj_external_point_ptr_->get_trajectory_msg();
-  auto new_external_msg = traj_msg_external_point_ptr_.readFromRT();
-  if (current_external_msg != *new_external_msg)
+  // nothing in here may allocate, only storage prepared in on_configure() is used
+  RealtimeAllocationGuard allocation_guard;
+
+  // Check if a new trajectory has been prepared by nonRT threads
+  const auto & prepared = *traj_msg_external_point_ptr_.readFromRT();
+  if (prepared.trajectory && prepared.trajectory != traj_external_point_ptr_)
   {
-    fill_partial_goal(*new_external_msg);
-    sort_to_local_joint_order(*new_external_msg);
-    traj_external_point_ptr_->update(*new_external_msg);
+    if (prepared.spliced_onto && prepared.spliced_onto == traj_external_point_ptr_)
+    {
+      prepared.trajectory->continue_from(*traj_external_point_ptr_);
+    }
+    // the buffer still references the previous trajectory, it is not released here
+    traj_external_point_ptr_ = prepared.trajectory;
   }
-
-  JointTrajectoryPoint state_current, state_desired, state_error;
   const auto joint_num = joint_names_.size();
-  resize_joint_trajectory_point(state_current, joint_num);
 
   // TODO(anyone): can I here also use const on joint_interface since the reference_wrapper is not
   // changed, but its value only?
@@ -162,37 +191,36 @@ controller_interface::return_type JointTrajectoryController::update(
   };
 
   // current state update
-  state_current.time_from_start.set__sec(0);
-  read_state_from_hardware(state_current);
+  state_current_.time_from_start.set__sec(0);
+  read_state_from_hardware(state_current_);
 
   // currently carrying out a trajectory
-  if (traj_point_active_ptr_ && (*traj_point_active_ptr_)->has_trajectory_msg())
+  if (
+    traj_point_active_ptr_ && *traj_point_active_ptr_ &&
+    (*traj_point_active_ptr_)->has_trajectory_msg())
   {
 
     // if sampling the first time, set the point before you sample
     if (!(*traj_point_active_ptr_)->is_sampled_already())
     {
-
       if (open_loop_control_)
       {
         (*traj_point_active_ptr_)
-          ->set_point_before_trajectory_msg(node_->now(), last_commanded_state_);
+          ->set_point_before_trajectory_msg(time, last_commanded_state_);
 
       }
       else
       {
-        (*traj_point_active_ptr_)->set_point_before_trajectory_msg(node_->now(), state_current);
-
+        (*traj_point_active_ptr_)->set_point_before_trajectory_msg(time, state_current_);
       }
     }
-    resize_joint_trajectory_point(state_error, joint_num);
 
     // find segment for current timestamp
     TrajectoryPointConstIter start_segment_itr, end_segment_itr;
     // TODO(anyone): this is kind-of open-loop concept? I am right?
     const bool valid_point =
       (*traj_point_active_ptr_)
-        ->sample(node_->now(), state_desired, start_segment_itr, end_segment_itr);
+        ->sample(time, state_desired_, start_segment_itr, end_segment_itr);
 
     if (valid_point)
     {
@@ -203,90 +231,128 @@ controller_interface::return_type JointTrajectoryController::update(
       // set values for next hardware write()
       if (use_closed_loop_pid_adapter && has_effort_command_interface_)
       {
-        const auto period = std::chrono::steady_clock::now() - last_update_time_;
-        for (auto index = 0ul; index < joint_num; ++index)
+        const auto dt_ns = static_cast<uint64_t>(std::max<int64_t>(0, period.nanoseconds()));
+        for (auto index = 0ul; index < feedforward_effort_.size(); ++index)
+        {
+          feedforward_effort_[index] =
+            (feedforward_gravity_ ? gravity_state_interface_[index].get().get_value() : 0.0) +
+            (feedforward_coriolis_ ? coriolis_state_interface_[index].get().get_value() : 0.0);
+        }
+        const GainSchedule & schedule = **gain_schedule_.readFromRT();
+        const double schedule_variable =
+          gain_schedule_interface_ ? gain_schedule_interface_->get_value() : 0.0;
+        auto set_effort_command = [&](auto & pid) {
+          pid.set_gains(schedule, schedule_variable);
+          const auto & command =
+            pid.compute_effort(state_desired_, state_current_, dt_ns, feedforward_effort_);
+          for (auto index = 0ul; index < joint_num; ++index)
+          {
+            joint_command_interface_[3][index].get().set_value(command[index]);
+          }
+        };
+        if (use_fixed_size_core_)
+        {
+          set_effort_command(fixed_size_pid_);
+        }
+        else
         {
-          const double command =
-            (state_desired.velocities[index] * velocity_ff_[index]) +
-            pids_[index]->computeCommand(
-              state_desired.positions[index] - state_current.positions[index],
-              state_desired.velocities[index] - state_current.velocities[index], period.count());
-          joint_command_interface_[3][index].get().set_value(command);
+          set_effort_command(pid_);
         }
-        last_update_time_ = std::chrono::steady_clock::now();
       }
       else
       {
         if (has_position_command_interface_)
         {
-          assign_interface_from_point(joint_command_interface_[0], state_desired.positions);
+          assign_interface_from_point(joint_command_interface_[0], state_desired_.positions);
         }
         if (has_velocity_command_interface_)
         {
-          assign_interface_from_point(joint_command_interface_[1], state_desired.velocities);
+          assign_interface_from_point(joint_command_interface_[1], state_desired_.velocities);
         }
         if (has_acceleration_command_interface_)
         {
-          assign_interface_from_point(joint_command_interface_[2], state_desired.accelerations);
+          assign_interface_from_point(joint_command_interface_[2], state_desired_.accelerations);
         }
       }
 
-      for (auto index = 0ul; index < joint_num; ++index)
+      if (use_fixed_size_core_)
       {
-        compute_error_for_joint(state_error, index, state_current, state_desired);
-
-        if (
-          before_last_point &&
-          !check_state_tolerance_per_joint(
-            state_error, index, default_tolerances_.state_tolerance[index], false))
-        {
-          abort = true;
-        }
-        // past the final point, check that we end up inside goal tolerance
-        if (
-          !before_last_point &&
-          !check_state_tolerance_per_joint(
-            state_error, index, default_tolerances_.goal_state_tolerance[index], false))
+        fixed_size_core_.compute_error(
+          state_current_, state_desired_,
+          has_velocity_state_interface_ && has_velocity_command_interface_,
+          has_acceleration_state_interface_ && has_acceleration_command_interface_, state_error_);
+        abort = before_last_point && !fixed_size_core_.within_tolerance(state_error_, false);
+        outside_goal_tolerance =
+          !before_last_point && !fixed_size_core_.within_tolerance(state_error_, true);
+      }
+      else
+      {
+        for (auto index = 0ul; index < joint_num; ++index)
         {
-          outside_goal_tolerance = true;
+          compute_error_for_joint(state_error_, index, state_current_, state_desired_);
+
+          if (
+            before_last_point &&
+            !check_state_tolerance_per_joint(
+              state_error_, index, default_tolerances_.state_tolerance[index], false))
+          {
+            abort = true;
+          }
+          // past the final point, check that we end up inside goal tolerance
+          if (
+            !before_last_point &&
+            !check_state_tolerance_per_joint(
+              state_error_, index, default_tolerances_.goal_state_tolerance[index], false))
+          {
+            outside_goal_tolerance = true;
+          }
         }
       }
 
       // store command as state when hardware state has tracking offset
-      last_commanded_state_ = state_desired;
+      last_commanded_state_ = state_desired_;
+      // the callbacks read the hold positions, skip a cycle instead of waiting for them
+      std::unique_lock<std::mutex> hold_lock(hold_positions_mutex_, std::try_to_lock);
+      if (hold_lock.owns_lock())
+      {
+        std::copy(
+          last_commanded_state_.positions.begin(), last_commanded_state_.positions.end(),
+          hold_positions_.begin());
+      }
 
       const auto active_goal = *rt_active_goal_.readFromRT();
-      if (active_goal)
+      // a finished goal stays in rt_active_goal_ until the goal timer reported its result
+      if (active_goal && active_goal.get() != rt_finished_goal_)
       {
-        // send feedback
-        auto feedback = std::make_shared<FollowJTrajAction::Feedback>();
-        feedback->header.stamp = node_->now();
-        feedback->joint_names = joint_names_;
-
-        feedback->actual = state_current;
-        feedback->desired = state_desired;
-        feedback->error = state_error;
-        active_goal->setFeedback(feedback);
+        // send feedback at the feedback rate, the first one of a goal right away. The goal timer
+        // publishes it, setFeedback() would wait for the goal handle while it publishes
+        if (
+          (active_goal.get() != feedback_goal_ ||
+           time >= last_feedback_time_ + action_feedback_period_) &&
+          ready_feedback_.load(std::memory_order_acquire) == nullptr)
+        {
+          const auto & feedback = feedback_buffers_[feedback_buffer_index_];
+          feedback_buffer_index_ = 1 - feedback_buffer_index_;
+          feedback->header.stamp = time;
+          feedback->actual = state_current_;
+          feedback->desired = state_desired_;
+          feedback->error = state_error_;
+          ready_feedback_.store(feedback.get(), std::memory_order_release);
+          feedback_goal_ = active_goal.get();
+          last_feedback_time_ = time;
+        }
 
         // check abort
         if (abort || outside_goal_tolerance)
         {
-          auto result = std::make_shared<FollowJTrajAction::Result>();
-
           if (abort)
           {
-            RCLCPP_WARN(node_->get_logger(), "Aborted due to state tolerance violation");
-            result->set__error_code(FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
+            finish_goal(active_goal, FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
           }
           else if (outside_goal_tolerance)
           {
-            RCLCPP_WARN(node_->get_logger(), "Aborted due to goal tolerance violation");
-            result->set__error_code(FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
+            finish_goal(active_goal, FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
           }
-          active_goal->setAborted(result);
-          // TODO(matthew-reynolds): Need a lock-free write here
-          // See https://github.com/ros-controls/ros2_controllers/issues/168
-          rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
 
           // check goal tolerance
         }
@@ -294,14 +360,7 @@ controller_interface::return_type JointTrajectoryController::update(
         {
           if (!outside_goal_tolerance)
           {
-            auto res = std::make_shared<FollowJTrajAction::Result>();
-            res->set__error_code(FollowJTrajAction::Result::SUCCESSFUL);
-            active_goal->setSucceeded(res);
-            // TODO(matthew-reynolds): Need a lock-free write here
-            // See https://github.com/ros-controls/ros2_controllers/issues/168
-            rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-
-            RCLCPP_INFO(node_->get_logger(), "Goal reached, success!");
+            finish_goal(active_goal, FollowJTrajAction::Result::SUCCESSFUL);
           }
           else if (default_tolerances_.goal_time_tolerance != 0.0)
           {
@@ -309,29 +368,18 @@ controller_interface::return_type JointTrajectoryController::update(
             const rclcpp::Time traj_start = (*traj_point_active_ptr_)->get_trajectory_start_time();
             const rclcpp::Time traj_end = traj_start + start_segment_itr->time_from_start;
 
-            const double difference = node_->now().seconds() - traj_end.seconds();
+            const double difference = time.seconds() - traj_end.seconds();
             if (difference > default_tolerances_.goal_time_tolerance)
             {
-              auto result = std::make_shared<FollowJTrajAction::Result>();
-              result->set__error_code(FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
-              active_goal->setAborted(result);
-              // TODO(matthew-reynolds): Need a lock-free write here
-              // See https://github.com/ros-controls/ros2_controllers/issues/168
-              rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-              RCLCPP_WARN(
-                node_->get_logger(), "Aborted due goal_time_tolerance exceeding by %f seconds",
-                difference);
+              finish_goal(active_goal, FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
             }
           }
         }
       }
     }
-  } else {
-    // TODO temporary solution to keep the initial position before the first trajectory goal arrives
-    set_hold_position();
   }
 
-  publish_state(state_desired, state_current, state_error);
+  publish_state(time, state_desired_, state_current_, state_error_);
   return controller_interface::return_type::OK;
 }
 
@@ -550,21 +598,66 @@ CallbackReturn JointTrajectoryController::on_configure(const rclcpp_lifecycle::S
     return CallbackReturn::FAILURE;
   }
 
+  use_fixed_size_core_ = joint_names_.size() == kFixedSizeJoints;
   if (use_closed_loop_pid_adapter)
   {
     for (const auto & joint_name : joint_names_)
     {
       // Init PID gains from ROS parameter server
       const std::string prefix = "gains." + joint_name;
-      const auto k_p = auto_declare<double>(prefix + ".p", 0.0);
-      const auto k_i = auto_declare<double>(prefix + ".i", 0.0);
-      const auto k_d = auto_declare<double>(prefix + ".d", 0.0);
-      const auto i_clamp = auto_declare<double>(prefix + ".i_clamp", 0.0);
-      const auto velocity_ff = auto_declare<double>("velocity_ff." + joint_name, 0.0);
-      // Initialize PID
-      pids_.push_back(std::make_unique<control_toolbox::Pid>(k_p, k_i, k_d, i_clamp, -i_clamp));
-      velocity_ff_.push_back(velocity_ff);
+      auto_declare<double>(prefix + ".p", 0.0);
+      auto_declare<double>(prefix + ".i", 0.0);
+      auto_declare<double>(prefix + ".d", 0.0);
+      auto_declare<double>(prefix + ".i_clamp", 0.0);
+      auto_declare<double>("velocity_ff." + joint_name, 0.0);
+      // gains at the breakpoints, used instead of the constant gains if there are breakpoints
+      const std::string schedule_prefix = "gain_schedule." + joint_name;
+      for (const auto & gain : {".p", ".i", ".d", ".i_clamp"})
+      {
+        auto_declare<std::vector<double>>(schedule_prefix + gain, std::vector<double>());
+      }
+    }
+    gain_schedule_interface_name_ = node_->get_parameter("gain_schedule.interface").as_string();
+    feedforward_gravity_ = node_->get_parameter("feedforward.gravity").as_bool();
+    feedforward_coriolis_ = node_->get_parameter("feedforward.coriolis").as_bool();
+    if (feedforward_gravity_)
+    {
+      RCLCPP_WARN(
+        logger,
+        "Gravity feed-forward is enabled. Robots which compensate gravity themselves, like the "
+        "Panda in torque control, get compensated twice.");
     }
+
+    std::string error;
+    const auto schedule = make_gain_schedule({}, error);
+    if (!schedule)
+    {
+      RCLCPP_ERROR(logger, "Invalid gains: %s", error.c_str());
+      return CallbackReturn::FAILURE;
+    }
+    // both slots, so that update() never reads an empty schedule
+    gain_schedule_.initRT(schedule);
+    if (!gain_parameters_handle_)
+    {
+      gain_parameters_handle_ = node_->add_on_set_parameters_callback(
+        std::bind(&JointTrajectoryController::on_set_gain_parameters, this, std::placeholders::_1));
+    }
+
+    pid_.resize(use_fixed_size_core_ ? 0 : joint_names_.size());
+    fixed_size_pid_.resize(kFixedSizeJoints);
+    feedforward_effort_.assign(
+      feedforward_gravity_ || feedforward_coriolis_ ? joint_names_.size() : 0, 0.0);
+    RCLCPP_INFO(
+      logger, "Gains are %s.",
+      schedule->breakpoints.size() > 1
+        ? ("scheduled on '" + gain_schedule_interface_name_ + "'").c_str()
+        : "constant");
+  }
+  else
+  {
+    gain_schedule_interface_name_.clear();
+    feedforward_gravity_ = false;
+    feedforward_coriolis_ = false;
   }
 
   // Read always state interfaces from the parameter because they can be used
@@ -648,15 +741,62 @@ CallbackReturn JointTrajectoryController::on_configure(const rclcpp_lifecycle::S
     get_interface_list(state_interface_types_).c_str());
 
   default_tolerances_ = get_segment_tolerances(*node_, joint_names_);
+  if (use_fixed_size_core_)
+  {
+    fixed_size_core_.set_tolerances(default_tolerances_);
+  }
 
   // Read parameters customizing controller for special cases
   open_loop_control_ = node_->get_parameter("open_loop_control").get_value<bool>();
+  trajectory_append_mode_ = node_->get_parameter("trajectory_append_mode").get_value<bool>();
+  if (trajectory_append_mode_)
+  {
+    RCLCPP_INFO(logger, "Trajectories received on the topic are appended to the active one");
+  }
+  const double resample_period = node_->get_parameter("resample_period").get_value<double>();
+  if (resample_period < 0.0)
+  {
+    RCLCPP_ERROR(logger, "'resample_period' has to be >= 0, but is %f", resample_period);
+    return CallbackReturn::FAILURE;
+  }
+  resample_period_ns_ = rclcpp::Duration::from_seconds(resample_period).nanoseconds();
+  if (resample_period_ns_ > 0)
+  {
+    RCLCPP_INFO(logger, "Trajectories are resampled every %f s", resample_period);
+  }
+
+  max_velocities_.assign(joint_names_.size(), 0.0);
+  max_accelerations_.assign(joint_names_.size(), 0.0);
+  has_trajectory_limits_ = false;
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    const std::string prefix = "limits." + joint_names_[i];
+    auto_declare<double>(prefix + ".max_velocity", 0.0);
+    auto_declare<double>(prefix + ".max_acceleration", 0.0);
+    max_velocities_[i] = node_->get_parameter(prefix + ".max_velocity").as_double();
+    max_accelerations_[i] = node_->get_parameter(prefix + ".max_acceleration").as_double();
+    if (max_velocities_[i] < 0.0 || max_accelerations_[i] < 0.0)
+    {
+      RCLCPP_ERROR(logger, "The limits of joint %s have to be >= 0", joint_names_[i].c_str());
+      return CallbackReturn::FAILURE;
+    }
+    has_trajectory_limits_ =
+      has_trajectory_limits_ || max_velocities_[i] > 0.0 || max_accelerations_[i] > 0.0;
+  }
+  scale_trajectories_ = node_->get_parameter("limits.scale_trajectories").get_value<bool>();
+  if (has_trajectory_limits_)
+  {
+    RCLCPP_INFO(
+      logger, "Trajectories which exceed the joint limits are %s",
+      scale_trajectories_ ? "slowed down" : "rejected");
+  }
 
   // subscriber callback
   // non realtime
   // TODO(karsten): check if traj msg and point time are valid
   auto callback = [this](const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg) -> void {
-    if (!validate_trajectory_msg(*msg))
+    double time_scale = 1.0;
+    if (!validate_trajectory_msg(*msg) || !check_trajectory_limits(*msg, time_scale))
     {
       return;
     }
@@ -665,7 +805,7 @@ CallbackReturn JointTrajectoryController::on_configure(const rclcpp_lifecycle::S
     // always replace old msg with new one for now
     if (subscriber_is_active_)
     {
-      add_new_trajectory_msg(msg);
+      add_new_trajectory_msg(msg, trajectory_append_mode_, time_scale);
     }
   };
 
@@ -678,7 +818,17 @@ CallbackReturn JointTrajectoryController::on_configure(const rclcpp_lifecycle::S
 
   // State publisher
   const double state_publish_rate = node_->get_parameter("state_publish_rate").get_value<double>();
-  RCLCPP_INFO(logger, "Controller state will be published at %.2f Hz.", state_publish_rate);
+  state_publish_decimation_ = std::max(
+    0, static_cast<int>(node_->get_parameter("state_publish_decimation").as_int()));
+  if (state_publish_decimation_ > 0)
+  {
+    RCLCPP_INFO(
+      logger, "Controller state will be published every %d updates.", state_publish_decimation_);
+  }
+  else
+  {
+    RCLCPP_INFO(logger, "Controller state will be published at %.2f Hz.", state_publish_rate);
+  }
   if (state_publish_rate > 0.0)
   {
     state_publisher_period_ = rclcpp::Duration::from_seconds(1.0 / state_publish_rate);
@@ -712,6 +862,24 @@ CallbackReturn JointTrajectoryController::on_configure(const rclcpp_lifecycle::S
   }
   state_publisher_->unlock();
 
+  // working storage of update(), sampling always fills positions, velocities and accelerations
+  resize_joint_trajectory_point(state_current_, n_joints);
+  resize_joint_trajectory_point(state_error_, n_joints);
+  state_desired_.positions.resize(n_joints);
+  state_desired_.velocities.resize(n_joints);
+  state_desired_.accelerations.resize(n_joints);
+  state_desired_.effort.resize(n_joints);
+  for (auto & feedback : feedback_buffers_)
+  {
+    feedback = std::make_shared<FollowJTrajAction::Feedback>();
+    feedback->joint_names = joint_names_;
+    feedback->actual = state_current_;
+    feedback->desired = state_desired_;
+    feedback->error = state_error_;
+  }
+  feedback_buffer_index_ = 0;
+  ready_feedback_.store(nullptr);
+
   last_state_publish_time_ = node_->now();
 
   // action server configuration
@@ -726,6 +894,14 @@ CallbackReturn JointTrajectoryController::on_configure(const rclcpp_lifecycle::S
 
   RCLCPP_INFO(logger, "Action status changes will be monitored at %.2f Hz.", action_monitor_rate);
   action_monitor_period_ = rclcpp::Duration::from_seconds(1.0 / action_monitor_rate);
+  // feedback is only sent by the goal timer, more frequent updates are never seen by clients
+  const double action_feedback_rate =
+    node_->get_parameter("action_feedback_rate").get_value<double>();
+  action_feedback_period_ = action_feedback_rate > 0.0
+                              ? rclcpp::Duration::from_seconds(1.0 / action_feedback_rate)
+                              : action_monitor_period_;
+  RCLCPP_INFO(
+    logger, "Action feedback will be updated at %.2f Hz.", 1.0 / action_feedback_period_.seconds());
 
   using namespace std::placeholders;
   action_server_ = rclcpp_action::create_server<FollowJTrajAction>(
@@ -793,6 +969,42 @@ CallbackReturn JointTrajectoryController::on_activate(const rclcpp_lifecycle::St
     }
   }
 
+  if (use_closed_loop_pid_adapter)
+  {
+    gain_schedule_interface_ = nullptr;
+    for (const auto & interface : state_interfaces_)
+    {
+      if (
+        interface.get_name() + "/" + interface.get_interface_name() ==
+        gain_schedule_interface_name_)
+      {
+        gain_schedule_interface_ = &interface;
+      }
+    }
+    if (!gain_schedule_interface_name_.empty() && !gain_schedule_interface_)
+    {
+      RCLCPP_ERROR(
+        node_->get_logger(), "Missing state interface '%s' for the gain schedule.",
+        gain_schedule_interface_name_.c_str());
+      return CallbackReturn::ERROR;
+    }
+    if (
+      (feedforward_gravity_ &&
+       !get_ordered_interfaces(
+         state_interfaces_, joint_names_, "gravity", gravity_state_interface_)) ||
+      (feedforward_coriolis_ &&
+       !get_ordered_interfaces(
+         state_interfaces_, joint_names_, "coriolis", coriolis_state_interface_)))
+    {
+      RCLCPP_ERROR(
+        node_->get_logger(), "Expected %zu 'gravity' and/or 'coriolis' state interfaces.",
+        joint_names_.size());
+      return CallbackReturn::ERROR;
+    }
+    pid_.reset();
+    fixed_size_pid_.reset();
+  }
+
   // Store 'home' pose
   traj_msg_home_ptr_ = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
   traj_msg_home_ptr_->header.stamp.sec = 0;
@@ -807,14 +1019,21 @@ CallbackReturn JointTrajectoryController::on_activate(const rclcpp_lifecycle::St
       joint_state_interface_[0][index].get().get_value();
   }
 
-  traj_external_point_ptr_ = std::make_shared<Trajectory>();
+  // set by update() from traj_msg_external_point_ptr_, starting with the hold position below
+  traj_external_point_ptr_.reset();
   traj_home_point_ptr_ = std::make_shared<Trajectory>();
-  traj_msg_external_point_ptr_.writeFromNonRT(
-    std::shared_ptr<trajectory_msgs::msg::JointTrajectory>());
+  traj_msg_external_point_ptr_.writeFromNonRT(PreparedTrajectory());
+  {
+    std::lock_guard<std::mutex> guard(prepared_msg_mutex_);
+    last_prepared_trajectory_.reset();
+  }
 
   subscriber_is_active_ = true;
   traj_point_active_ptr_ = &traj_external_point_ptr_;
   last_state_publish_time_ = node_->now();
+  state_publish_ticks_ = 0;
+  feedback_goal_ = nullptr;
+  ready_feedback_.store(nullptr);
 
   // Initialize current state storage if hardware state has tracking offset
   resize_joint_trajectory_point(last_commanded_state_, joint_names_.size());
@@ -827,6 +1046,17 @@ CallbackReturn JointTrajectoryController::on_activate(const rclcpp_lifecycle::St
   {
     last_commanded_state_ = state;
   }
+  // update() copies the desired state in here
+  last_commanded_state_.velocities.reserve(joint_names_.size());
+  last_commanded_state_.accelerations.reserve(joint_names_.size());
+  last_commanded_state_.effort.reserve(joint_names_.size());
+  {
+    std::lock_guard<std::mutex> guard(hold_positions_mutex_);
+    hold_positions_ = last_commanded_state_.positions;
+  }
+
+  // keep the current position until the first trajectory arrives
+  set_hold_position();
 
   // TODO(karsten1987): activate subscriptions of subscriber
   return CallbackReturn::SUCCESS;
@@ -846,6 +1076,9 @@ CallbackReturn JointTrajectoryController::on_deactivate(const rclcpp_lifecycle::
     joint_command_interface_[index].clear();
     joint_state_interface_[index].clear();
   }
+  gravity_state_interface_.clear();
+  coriolis_state_interface_.clear();
+  gain_schedule_interface_ = nullptr;
   release_interfaces();
 
   subscriber_is_active_ = false;
@@ -876,10 +1109,8 @@ bool JointTrajectoryController::reset()
   subscriber_is_active_ = false;
   joint_command_subscriber_.reset();
 
-  for (const auto & pid : pids_)
-  {
-    pid->reset();
-  }
+  pid_.reset();
+  fixed_size_pid_.reset();
 
   // iterator has no default value
   // prev_traj_point_ptr_;
@@ -891,6 +1122,116 @@ bool JointTrajectoryController::reset()
   return true;
 }
 
+std::shared_ptr<const GainSchedule> JointTrajectoryController::make_gain_schedule(
+  const std::vector<rclcpp::Parameter> & overrides, std::string & error) const
+{
+  auto get_parameter = [&](const std::string & name) {
+    for (const auto & parameter : overrides)
+    {
+      if (parameter.get_name() == name)
+      {
+        return parameter;
+      }
+    }
+    return node_->get_parameter(name);
+  };
+
+  const auto n_joints = joint_names_.size();
+  auto schedule = std::make_shared<GainSchedule>();
+  schedule->breakpoints = get_parameter("gain_schedule.breakpoints").as_double_array();
+  const bool scheduled = !schedule->breakpoints.empty();
+  if (!scheduled)
+  {
+    // constant gains
+    schedule->breakpoints.push_back(0.0);
+  }
+  else if (gain_schedule_interface_name_.empty())
+  {
+    error = "'gain_schedule.breakpoints' are set, but no 'gain_schedule.interface'";
+    return nullptr;
+  }
+  else if (!std::is_sorted(
+             schedule->breakpoints.begin(), schedule->breakpoints.end(),
+             std::less_equal<double>()))
+  {
+    error = "'gain_schedule.breakpoints' have to be strictly ascending";
+    return nullptr;
+  }
+  const auto n_breakpoints = schedule->breakpoints.size();
+
+  schedule->velocity_ff.resize(static_cast<Eigen::Index>(n_joints));
+  for (auto * gains : {&schedule->p, &schedule->i, &schedule->d, &schedule->i_clamp})
+  {
+    gains->assign(n_breakpoints, Eigen::VectorXd(static_cast<Eigen::Index>(n_joints)));
+  }
+  for (auto index = 0ul; index < n_joints; ++index)
+  {
+    const auto & joint_name = joint_names_[index];
+    const auto joint = static_cast<Eigen::Index>(index);
+    schedule->velocity_ff[joint] = get_parameter("velocity_ff." + joint_name).as_double();
+    auto set_gain = [&](const std::string & gain, std::vector<Eigen::VectorXd> & gains) {
+      if (!scheduled)
+      {
+        gains[0][joint] = get_parameter("gains." + joint_name + "." + gain).as_double();
+        return true;
+      }
+      const std::string name = "gain_schedule." + joint_name + "." + gain;
+      const auto values = get_parameter(name).as_double_array();
+      if (values.size() != n_breakpoints)
+      {
+        error = "'" + name + "' has " + std::to_string(values.size()) + " values, expected " +
+                std::to_string(n_breakpoints);
+        return false;
+      }
+      for (auto breakpoint = 0ul; breakpoint < n_breakpoints; ++breakpoint)
+      {
+        gains[breakpoint][joint] = values[breakpoint];
+      }
+      return true;
+    };
+    if (
+      !set_gain("p", schedule->p) || !set_gain("i", schedule->i) || !set_gain("d", schedule->d) ||
+      !set_gain("i_clamp", schedule->i_clamp))
+    {
+      return nullptr;
+    }
+  }
+  return schedule;
+}
+
+rcl_interfaces::msg::SetParametersResult JointTrajectoryController::on_set_gain_parameters(
+  const std::vector<rclcpp::Parameter> & parameters)
+{
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  const bool affects_gains = std::any_of(
+    parameters.begin(), parameters.end(), [](const rclcpp::Parameter & parameter) {
+      const auto & name = parameter.get_name();
+      return name.rfind("gains.", 0) == 0 || name.rfind("velocity_ff.", 0) == 0 ||
+             (name.rfind("gain_schedule.", 0) == 0 && name != "gain_schedule.interface");
+    });
+  if (!affects_gains)
+  {
+    return result;
+  }
+
+  try
+  {
+    auto schedule = make_gain_schedule(parameters, result.reason);
+    if (!schedule)
+    {
+      result.successful = false;
+      return result;
+    }
+    gain_schedule_.writeFromNonRT(schedule);
+  }
+  catch (const rclcpp::exceptions::ParameterNotDeclaredException &)
+  {
+    // gains of new joints are declared by on_configure(), which builds the schedule afterwards
+  }
+  return result;
+}
+
 CallbackReturn JointTrajectoryController::on_shutdown(const rclcpp_lifecycle::State &)
 {
   // TODO(karsten1987): what to do?
@@ -899,23 +1240,38 @@ CallbackReturn JointTrajectoryController::on_shutdown(const rclcpp_lifecycle::St
 }
 
 void JointTrajectoryController::publish_state(
-  const JointTrajectoryPoint & desired_state, const JointTrajectoryPoint & current_state,
+  const rclcpp::Time & time, const JointTrajectoryPoint & desired_state, const JointTrajectoryPoint & current_state,
   const JointTrajectoryPoint & state_error)
 {
-  if (state_publisher_period_.seconds() <= 0.0)
+  if (state_publish_decimation_ > 0)
+  {
+    if (++state_publish_ticks_ < state_publish_decimation_)
+    {
+      return;
+    }
+    state_publish_ticks_ = 0;
+  }
+  else if (state_publisher_period_.seconds() <= 0.0)
   {
     return;
   }
 
-  if (node_->now() < (last_state_publish_time_ + state_publisher_period_))
+  if (
+    state_publish_decimation_ == 0 && time < (last_state_publish_time_ + state_publisher_period_))
   {
     return;
   }
+  last_state_publish_time_ = time;
 
-  if (state_publisher_ && state_publisher_->trylock())
+  // nobody listens, skip copying the state
+  if (!state_publisher_ || publisher_->get_subscription_count() == 0)
   {
-    last_state_publish_time_ = node_->now();
-    state_publisher_->msg_.header.stamp = last_state_publish_time_;
+    return;
+  }
+
+  if (state_publisher_->trylock())
+  {
+    state_publisher_->msg_.header.stamp = time;
     state_publisher_->msg_.desired.positions = desired_state.positions;
     state_publisher_->msg_.desired.velocities = desired_state.velocities;
     state_publisher_->msg_.desired.accelerations = desired_state.accelerations;
@@ -948,7 +1304,11 @@ rclcpp_action::GoalResponse JointTrajectoryController::goal_callback(
     return rclcpp_action::GoalResponse::REJECT;
   }
 
-  if (!validate_trajectory_msg(goal->trajectory))
+  // the limits are checked before the goal is accepted, update() only samples the trajectory
+  double time_scale = 1.0;
+  if (
+    !validate_trajectory_msg(goal->trajectory) ||
+    !check_trajectory_limits(goal->trajectory, time_scale))
   {
     return rclcpp_action::GoalResponse::REJECT;
   }
@@ -962,6 +1322,9 @@ rclcpp_action::CancelResponse JointTrajectoryController::cancel_callback(
 {
   RCLCPP_INFO(node_->get_logger(), "Got request to cancel goal");
 
+  // a goal that update() has already finished is reported as such
+  report_finished_goal(*rt_active_goal_.readFromNonRT());
+
   // Check that cancel request refers to currently active goal (if any)
   const auto active_goal = *rt_active_goal_.readFromNonRT();
   if (active_goal && active_goal->gh_ == goal_handle)
@@ -990,7 +1353,10 @@ void JointTrajectoryController::feedback_setup_callback(
     auto traj_msg =
       std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal_handle->get_goal()->trajectory);
 
-    add_new_trajectory_msg(traj_msg);
+    // computed again from the goal itself, goal_callback() may have checked a different goal since
+    size_t limiting_joint = 0;
+    const double time_scale = compute_trajectory_time_scale(*traj_msg, limiting_joint);
+    add_new_trajectory_msg(traj_msg, false, time_scale);
   }
 
   // Update the active goal
@@ -1001,8 +1367,84 @@ void JointTrajectoryController::feedback_setup_callback(
 
   // Setup goal status checking timer
   goal_handle_timer_ = node_->create_wall_timer(
-    action_monitor_period_.to_chrono<std::chrono::seconds>(),
-    std::bind(&RealtimeGoalHandle::runNonRealtime, rt_goal));
+    action_monitor_period_.to_chrono<std::chrono::seconds>(), [this, rt_goal]() {
+      report_finished_goal(rt_goal);
+      take_ready_feedback(rt_goal);
+      rt_goal->runNonRealtime();
+    });
+}
+
+void JointTrajectoryController::take_ready_feedback(const RealtimeGoalHandlePtr & goal)
+{
+  // taken before it is published by runNonRealtime(), update() fills the other buffer meanwhile
+  const FollowJTrajAction::Feedback * feedback =
+    ready_feedback_.exchange(nullptr, std::memory_order_acq_rel);
+  if (feedback == nullptr)
+  {
+    return;
+  }
+  for (const auto & buffer : feedback_buffers_)
+  {
+    if (buffer.get() == feedback)
+    {
+      goal->setFeedback(buffer);
+    }
+  }
+}
+
+void JointTrajectoryController::finish_goal(const RealtimeGoalHandlePtr & goal, int32_t error_code)
+{
+  // the previous goal is still handed over, its owner must not be released here
+  if (finished_goal_.load(std::memory_order_acquire) != nullptr)
+  {
+    return;
+  }
+  // nobody reads the result before the goal is handed over below
+  goal->preallocated_result_->set__error_code(error_code);
+  // report_finished_goal() moved the previous owner out, so this only adds a reference
+  finished_goal_owner_ = goal;
+  rt_finished_goal_ = goal.get();
+  finished_goal_.store(goal.get(), std::memory_order_release);
+}
+
+void JointTrajectoryController::report_finished_goal(const RealtimeGoalHandlePtr & goal)
+{
+  const RealtimeGoalHandle * finished = finished_goal_.load(std::memory_order_acquire);
+  if (finished == nullptr)
+  {
+    return;
+  }
+  // the goal is released here at the earliest, when the next finished goal is handed over
+  reported_goal_ = std::move(finished_goal_owner_);
+  finished_goal_.store(nullptr, std::memory_order_release);
+  if (!goal || goal.get() != finished)
+  {
+    return;
+  }
+
+  const auto & result = goal->preallocated_result_;
+  switch (result->error_code)
+  {
+    case FollowJTrajAction::Result::SUCCESSFUL:
+      goal->setSucceeded(result);
+      RCLCPP_INFO(node_->get_logger(), "Goal reached, success!");
+      break;
+    case FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED:
+      goal->setAborted(result);
+      RCLCPP_WARN(node_->get_logger(), "Aborted due to state tolerance violation");
+      break;
+    default:
+      goal->setAborted(result);
+      RCLCPP_WARN(node_->get_logger(), "Aborted due to goal tolerance violation");
+      break;
+  }
+  goal->runNonRealtime();
+
+  // a new goal may already have replaced this one
+  if (*rt_active_goal_.readFromNonRT() == goal)
+  {
+    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+  }
 }
 
 void JointTrajectoryController::fill_partial_goal(
@@ -1015,6 +1457,11 @@ void JointTrajectoryController::fill_partial_goal(
     return;
   }
 
+  std::vector<double> hold_positions;
+  {
+    std::lock_guard<std::mutex> guard(hold_positions_mutex_);
+    hold_positions = hold_positions_;
+  }
   trajectory_msg->joint_names.reserve(joint_names_.size());
 
   for (auto index = 0ul; index < joint_names_.size(); ++index)
@@ -1030,10 +1477,11 @@ void JointTrajectoryController::fill_partial_goal(
       }
       trajectory_msg->joint_names.push_back(joint_names_[index]);
 
+      const double hold_position = hold_positions[index];
       for (auto & it : trajectory_msg->points)
       {
         // Assume hold position with 0 velocity and acceleration for missing joints
-        it.positions.push_back(joint_command_interface_[0][index].get().get_value());
+        it.positions.push_back(hold_position);
         if (!it.velocities.empty())
         {
           it.velocities.push_back(0.0);
@@ -1196,14 +1644,161 @@ bool JointTrajectoryController::validate_trajectory_msg(
   return true;
 }
 
+double JointTrajectoryController::compute_trajectory_time_scale(
+  const trajectory_msgs::msg::JointTrajectory & trajectory, size_t & limiting_joint) const
+{
+  limiting_joint = 0;
+  if (!has_trajectory_limits_)
+  {
+    return 1.0;
+  }
+  // the limits in the joint order of the trajectory
+  const auto joint_indices = mapping(trajectory.joint_names, joint_names_);
+  std::vector<double> max_velocities(joint_indices.size());
+  std::vector<double> max_accelerations(joint_indices.size());
+  for (size_t i = 0; i < joint_indices.size(); ++i)
+  {
+    max_velocities[i] = max_velocities_[joint_indices[i]];
+    max_accelerations[i] = max_accelerations_[joint_indices[i]];
+  }
+  // the resampled trajectory is checked at its samples
+  const int64_t step_ns =
+    resample_period_ns_ > 0 ? resample_period_ns_ : rclcpp::Duration(1ms).nanoseconds();
+  return compute_time_scale(trajectory, max_velocities, max_accelerations, step_ns, limiting_joint);
+}
+
+bool JointTrajectoryController::check_trajectory_limits(
+  const trajectory_msgs::msg::JointTrajectory & trajectory, double & time_scale) const
+{
+  size_t limiting_joint = 0;
+  time_scale = compute_trajectory_time_scale(trajectory, limiting_joint);
+  if (time_scale <= 1.0)
+  {
+    return true;
+  }
+  if (scale_trajectories_)
+  {
+    RCLCPP_INFO(
+      node_->get_logger(), "Slowing down the trajectory by %.2f for the limits of joint %s",
+      time_scale, trajectory.joint_names[limiting_joint].c_str());
+    return true;
+  }
+  RCLCPP_ERROR(
+    node_->get_logger(),
+    "Trajectory exceeds the velocity or acceleration limit of joint %s, it would have to be %.2f "
+    "times slower",
+    trajectory.joint_names[limiting_joint].c_str(), time_scale);
+  return false;
+}
+
 void JointTrajectoryController::add_new_trajectory_msg(
-  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg)
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg, bool append,
+  double time_scale)
+{
+  // done here, so that update() does not have to look up joint names and reallocate points
+  fill_partial_goal(traj_msg);
+  sort_to_local_joint_order(traj_msg);
+
+  // before splicing, so that only the new points are slowed down
+  if (time_scale > 1.0)
+  {
+    scale_trajectory_time(*traj_msg, time_scale);
+  }
+
+  std::lock_guard<std::mutex> guard(prepared_msg_mutex_);
+  PreparedTrajectory prepared;
+  if (append)
+  {
+    const rclcpp::Time now = node_->now();
+    // splicing needs absolute times, so the start time is fixed here instead of in update()
+    if (rclcpp::Time(traj_msg->header.stamp).nanoseconds() == 0)
+    {
+      traj_msg->header.stamp = now;
+    }
+    const auto active_msg =
+      last_prepared_trajectory_ ? last_prepared_trajectory_->get_trajectory_msg() : nullptr;
+    if (
+      active_msg && !active_msg->points.empty() &&
+      rclcpp::Time(active_msg->header.stamp).nanoseconds() != 0)
+    {
+      if (!splice_trajectory_msg(active_msg, now, *traj_msg))
+      {
+        RCLCPP_WARN(node_->get_logger(), "Ignoring trajectory, all of its points are in the past");
+        return;
+      }
+      prepared.spliced_onto = last_prepared_trajectory_;
+    }
+  }
+  // computes all spline coefficients
+  prepared.trajectory = std::make_shared<Trajectory>(traj_msg);
+  if (
+    resample_period_ns_ > 0 && traj_msg->points.size() > 1 &&
+    !prepared.trajectory->resample(resample_period_ns_))
+  {
+    RCLCPP_WARN(
+      node_->get_logger(), "Trajectory is too long to be resampled, its splines are sampled");
+  }
+  last_prepared_trajectory_ = prepared.trajectory;
+  traj_msg_external_point_ptr_.writeFromNonRT(prepared);
+}
+
+bool JointTrajectoryController::splice_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & active_msg,
+  const rclcpp::Time & now, trajectory_msgs::msg::JointTrajectory & msg) const
 {
-  traj_msg_external_point_ptr_.writeFromNonRT(traj_msg);
+  const rclcpp::Time msg_start = msg.header.stamp;
+  const auto first_new_point = std::find_if(
+    msg.points.begin(), msg.points.end(),
+    [&](const JointTrajectoryPoint & point) { return msg_start + point.time_from_start > now; });
+  if (first_new_point == msg.points.end())
+  {
+    return false;
+  }
+
+  const rclcpp::Time active_start = active_msg->header.stamp;
+  const rclcpp::Time splice_time = msg_start + first_new_point->time_from_start;
+  std::vector<JointTrajectoryPoint> points;
+  points.reserve(
+    active_msg->points.size() +
+    static_cast<size_t>(std::distance(first_new_point, msg.points.end())) + 1);
+  if (now < active_start + active_msg->points.front().time_from_start)
+  {
+    // not started yet, update() still interpolates from the state before the trajectory
+    for (const auto & point : active_msg->points)
+    {
+      if (active_start + point.time_from_start >= splice_time)
+      {
+        break;
+      }
+      points.push_back(point);
+    }
+  }
+  else
+  {
+    // cut at now, the new points continue from the state the active trajectory has there
+    Trajectory active_trajectory(active_start, active_msg->points.front(), active_msg);
+    JointTrajectoryPoint state_at_now;
+    TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+    active_trajectory.sample(now, state_at_now, start_segment_itr, end_segment_itr);
+    state_at_now.time_from_start = now - active_start;
+    points.push_back(state_at_now);
+  }
+
+  const rclcpp::Duration offset = msg_start - active_start;
+  for (auto it = first_new_point; it != msg.points.end(); ++it)
+  {
+    points.push_back(*it);
+    points.back().time_from_start = offset + it->time_from_start;
+  }
+
+  msg.header.stamp = active_msg->header.stamp;
+  msg.points = std::move(points);
+  return true;
 }
 
 void JointTrajectoryController::preempt_active_goal()
 {
+  report_finished_goal(*rt_active_goal_.readFromNonRT());
   const auto active_goal = *rt_active_goal_.readFromNonRT();
   if (active_goal)
   {
@@ -1221,7 +1816,12 @@ void JointTrajectoryController::set_hold_position()
   msg.header.stamp = rclcpp::Time(0);
   msg.joint_names = joint_names_;
   trajectory_msgs::msg::JointTrajectoryPoint point;
-  for (const auto& joint_position : last_commanded_state_.positions) {
+  std::vector<double> hold_positions;
+  {
+    std::lock_guard<std::mutex> guard(hold_positions_mutex_);
+    hold_positions = hold_positions_;
+  }
+  for (const auto& joint_position : hold_positions) {
     point.velocities.push_back(0);
     point.accelerations.push_back(0);
     point.positions.push_back(joint_position);
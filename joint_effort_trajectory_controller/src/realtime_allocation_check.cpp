@@ -0,0 +1,184 @@
+// Copyright (c) 2021 Franka Emika GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replaces the allocation functions of glibc, free() and operator delete by versions which abort
+// while the check is enabled for the calling thread. This only works if the library is loaded
+// before libc, i.e. with LD_PRELOAD; operator new ends up in malloc() and is covered as well.
+
+#include "joint_effort_trajectory_controller/realtime_allocation_check.hpp"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * pointer, size_t size);
+void * __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void * pointer);
+}
+
+namespace
+{
+// initial-exec, the general TLS model may itself allocate on first access
+__thread bool check_enabled __attribute__((tls_model("initial-exec"))) = false;
+std::atomic<bool> interposed{false};
+std::atomic<bool> warned{false};
+
+void write_to_stderr(const char * text)
+{
+  // no stdio, it may allocate
+  const ssize_t ignored = write(STDERR_FILENO, text, strlen(text));
+  static_cast<void>(ignored);
+}
+
+void check_allocation(const char * function)
+{
+  if (!interposed.load(std::memory_order_relaxed))
+  {
+    interposed.store(true, std::memory_order_relaxed);
+  }
+  if (check_enabled)
+  {
+    check_enabled = false;
+    write_to_stderr("[joint_trajectory_controller] ");
+    write_to_stderr(function);
+    write_to_stderr(" called in real-time context, aborting.\n");
+    std::abort();
+  }
+}
+
+void check_release(void * pointer, const char * function)
+{
+  // releasing nothing is fine, e.g. destroying an empty vector
+  if (pointer != nullptr)
+  {
+    check_allocation(function);
+  }
+}
+}  // namespace
+
+extern "C" {
+void * malloc(size_t size)
+{
+  check_allocation("malloc()");
+  return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size)
+{
+  check_allocation("calloc()");
+  return __libc_calloc(count, size);
+}
+
+void * realloc(void * pointer, size_t size)
+{
+  check_allocation("realloc()");
+  return __libc_realloc(pointer, size);
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+  check_allocation("aligned_alloc()");
+  return __libc_memalign(alignment, size);
+}
+
+void * memalign(size_t alignment, size_t size)
+{
+  check_allocation("memalign()");
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void ** pointer, size_t alignment, size_t size)
+{
+  check_allocation("posix_memalign()");
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+  {
+    return EINVAL;
+  }
+  void * result = __libc_memalign(alignment, size);
+  if (result == nullptr)
+  {
+    return ENOMEM;
+  }
+  *pointer = result;
+  return 0;
+}
+
+void free(void * pointer)
+{
+  check_release(pointer, "free()");
+  __libc_free(pointer);
+}
+}
+
+// libstdc++ implements them with free(), replaced as well for a message naming the caller
+void operator delete(void * pointer) noexcept
+{
+  check_release(pointer, "operator delete");
+  __libc_free(pointer);
+}
+
+void operator delete[](void * pointer) noexcept
+{
+  check_release(pointer, "operator delete[]");
+  __libc_free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+  check_release(pointer, "operator delete");
+  __libc_free(pointer);
+}
+
+void operator delete[](void * pointer, std::size_t) noexcept
+{
+  check_release(pointer, "operator delete[]");
+  __libc_free(pointer);
+}
+
+void operator delete(void * pointer, const std::nothrow_t &) noexcept
+{
+  check_release(pointer, "operator delete");
+  __libc_free(pointer);
+}
+
+void operator delete[](void * pointer, const std::nothrow_t &) noexcept
+{
+  check_release(pointer, "operator delete[]");
+  __libc_free(pointer);
+}
+
+namespace joint_trajectory_controller
+{
+bool set_allocation_check(bool enabled)
+{
+  if (!interposed.load(std::memory_order_relaxed) && !warned.exchange(true))
+  {
+    write_to_stderr(
+      "[joint_trajectory_controller] Allocation check is not active, preload "
+      "libjoint_effort_trajectory_controller_allocation_check.so with LD_PRELOAD.\n");
+  }
+  const bool previous = check_enabled;
+  check_enabled = enabled;
+  return previous;
+}
+
+}  // namespace joint_trajectory_controller
@@ -14,6 +14,9 @@
 
 #include "joint_effort_trajectory_controller/trajectory.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <memory>
 
 #include "hardware_interface/macros.hpp"
@@ -29,6 +32,7 @@ Trajectory::Trajectory(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> jo
 : trajectory_msg_(joint_trajectory),
   trajectory_start_time_(static_cast<rclcpp::Time>(joint_trajectory->header.stamp))
 {
+  preprocess();
 }
 
 Trajectory::Trajectory(
@@ -48,6 +52,8 @@ void Trajectory::set_point_before_trajectory_msg(
 {
   time_before_traj_msg_ = current_time;
   state_before_traj_msg_ = current_point;
+  first_segment_coefficients_.resize(kSplineCoefficients * current_point.positions.size());
+  first_segment_ready_ = false;
 }
 
 void Trajectory::update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory)
@@ -55,6 +61,170 @@ void Trajectory::update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> j
   trajectory_msg_ = joint_trajectory;
   trajectory_start_time_ = static_cast<rclcpp::Time>(joint_trajectory->header.stamp);
   sampled_already_ = false;
+  preprocess();
+}
+
+void Trajectory::continue_from(const Trajectory & previous)
+{
+  // the storage was reserved in preprocess(), so these copies do not allocate
+  time_before_traj_msg_ = previous.time_before_traj_msg_;
+  state_before_traj_msg_ = previous.state_before_traj_msg_;
+  first_segment_coefficients_.resize(
+    kSplineCoefficients * previous.state_before_traj_msg_.positions.size());
+  first_segment_ready_ = false;
+  sampled_already_ = previous.sampled_already_;
+}
+
+void Trajectory::preprocess()
+{
+  const auto & points = trajectory_msg_->points;
+  point_times_ns_.clear();
+  point_times_ns_.reserve(points.size());
+  for (const auto & point : points)
+  {
+    point_times_ns_.push_back(rclcpp::Duration(point.time_from_start).nanoseconds());
+  }
+  segment_cursor_ = 0;
+
+  dim_ = points.empty() ? 0 : points[0].positions.size();
+  const size_t segment_size = kSplineCoefficients * dim_;
+  segment_coefficients_.resize(points.size() > 1 ? (points.size() - 1) * segment_size : 0);
+  for (size_t i = 0; i + 1 < points.size(); ++i)
+  {
+    const double duration = 1e-9 * static_cast<double>(point_times_ns_[i + 1] - point_times_ns_[i]);
+    compute_spline_coefficients(
+      points[i], points[i + 1], duration, true, &segment_coefficients_[i * segment_size]);
+  }
+  first_segment_ready_ = false;
+  grid_period_ns_ = 0;
+  grid_.clear();
+  grid_segments_.clear();
+
+  // storage for set_point_before_trajectory_msg(), so that starting to sample does not allocate
+  first_segment_coefficients_.reserve(segment_size);
+  interpolation_coefficients_.reserve(segment_size);
+  state_before_traj_msg_.positions.reserve(dim_);
+  state_before_traj_msg_.velocities.reserve(dim_);
+  state_before_traj_msg_.accelerations.reserve(dim_);
+  state_before_traj_msg_.effort.reserve(dim_);
+}
+
+bool Trajectory::resample(int64_t period_ns)
+{
+  grid_period_ns_ = 0;
+  grid_.clear();
+  grid_segments_.clear();
+  if (period_ns <= 0 || point_times_ns_.size() < 2)
+  {
+    return false;
+  }
+  // samples before the last point, followed by one at the last point
+  const int64_t duration_ns = point_times_ns_.back() - point_times_ns_.front();
+  const size_t inner_samples = static_cast<size_t>((duration_ns + period_ns - 1) / period_ns);
+  if (inner_samples + 1 > kMaxResampledSamples)
+  {
+    return false;
+  }
+
+  const size_t sample_size = 3 * dim_;
+  const size_t segment_size = kSplineCoefficients * dim_;
+  grid_.resize((inner_samples + 1) * sample_size);
+  grid_segments_.resize(inner_samples + 1);
+  trajectory_msgs::msg::JointTrajectoryPoint state;
+  size_t segment = 0;
+  for (size_t k = 0; k <= inner_samples; ++k)
+  {
+    const int64_t time_ns = k < inner_samples
+                              ? point_times_ns_.front() + static_cast<int64_t>(k) * period_ns
+                              : point_times_ns_.back();
+    while (segment + 2 < point_times_ns_.size() && time_ns >= point_times_ns_[segment + 1])
+    {
+      ++segment;
+    }
+    evaluate_spline(
+      &segment_coefficients_[segment * segment_size], dim_,
+      1e-9 * static_cast<double>(time_ns - point_times_ns_[segment]), state);
+    double * sample = &grid_[k * sample_size];
+    std::copy(state.positions.begin(), state.positions.end(), sample);
+    std::copy(state.velocities.begin(), state.velocities.end(), sample + dim_);
+    std::copy(state.accelerations.begin(), state.accelerations.end(), sample + 2 * dim_);
+    grid_segments_[k] = static_cast<uint32_t>(segment);
+  }
+  grid_period_ns_ = period_ns;
+  return true;
+}
+
+size_t Trajectory::sample_grid(
+  int64_t time_from_start_ns, trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  const int64_t first_ns = point_times_ns_.front();
+  const size_t last_sample = grid_segments_.size() - 1;
+  const size_t k = std::min(
+    static_cast<size_t>((time_from_start_ns - first_ns) / grid_period_ns_), last_sample - 1);
+  const int64_t time_k = first_ns + static_cast<int64_t>(k) * grid_period_ns_;
+  // the last interval ends at the last point and may be shorter
+  const int64_t time_next =
+    k + 1 == last_sample ? point_times_ns_.back() : time_k + grid_period_ns_;
+  const double fraction =
+    static_cast<double>(time_from_start_ns - time_k) / static_cast<double>(time_next - time_k);
+
+  output.positions.resize(dim_);
+  output.velocities.resize(dim_);
+  output.accelerations.resize(dim_);
+  output.effort.clear();
+  const double * a = &grid_[k * 3 * dim_];
+  const double * b = a + 3 * dim_;
+  double * pos = output.positions.data();
+  double * vel = output.velocities.data();
+  double * acc = output.accelerations.data();
+  for (size_t i = 0; i < dim_; ++i)
+  {
+    pos[i] = a[i] + fraction * (b[i] - a[i]);
+  }
+  for (size_t i = dim_; i < 2 * dim_; ++i)
+  {
+    vel[i - dim_] = a[i] + fraction * (b[i] - a[i]);
+  }
+  for (size_t i = 2 * dim_; i < 3 * dim_; ++i)
+  {
+    acc[i - 2 * dim_] = a[i] + fraction * (b[i] - a[i]);
+  }
+
+  // points which are closer than the grid period end segments between two samples
+  size_t segment = grid_segments_[k];
+  while (segment + 2 < point_times_ns_.size() &&
+         time_from_start_ns >= point_times_ns_[segment + 1])
+  {
+    ++segment;
+  }
+  return segment;
+}
+
+size_t Trajectory::find_segment(int64_t time_from_start_ns)
+{
+  const size_t last_idx = point_times_ns_.size() - 1;
+  auto contains = [this](size_t i, int64_t t) {
+    return point_times_ns_[i] <= t && t < point_times_ns_[i + 1];
+  };
+
+  if (time_from_start_ns >= point_times_ns_[last_idx])
+  {
+    return last_idx;
+  }
+  // sampling usually moves forward by at most one segment per call
+  if (segment_cursor_ < last_idx && contains(segment_cursor_, time_from_start_ns))
+  {
+    return segment_cursor_;
+  }
+  if (segment_cursor_ + 1 < last_idx && contains(segment_cursor_ + 1, time_from_start_ns))
+  {
+    return ++segment_cursor_;
+  }
+  // first point after the sample time, the times are strictly increasing
+  const auto next_point =
+    std::upper_bound(point_times_ns_.begin(), point_times_ns_.end(), time_from_start_ns);
+  segment_cursor_ = static_cast<size_t>(std::distance(point_times_ns_.begin(), next_point)) - 1;
+  return segment_cursor_;
 }
 
 bool Trajectory::sample(
@@ -62,7 +232,6 @@ bool Trajectory::sample(
   TrajectoryPointConstIter & start_segment_itr, TrajectoryPointConstIter & end_segment_itr)
 {
   THROW_ON_NULLPTR(trajectory_msg_)
-  expected_state = trajectory_msgs::msg::JointTrajectoryPoint();
 
   if (trajectory_msg_->points.empty())
   {
@@ -94,11 +263,18 @@ bool Trajectory::sample(
   const rclcpp::Time first_point_timestamp = trajectory_start_time_ + offset;
   if (sample_time < first_point_timestamp)
   {
-    const rclcpp::Time t0 = time_before_traj_msg_;
-
-    interpolate_between_points(
-      t0, state_before_traj_msg_, first_point_timestamp, first_point_in_msg, sample_time,
-      expected_state);
+    // the segment depends on the start time, which is only known after the first sampling
+    if (!first_segment_ready_)
+    {
+      compute_spline_coefficients(
+        state_before_traj_msg_, first_point_in_msg,
+        (first_point_timestamp - time_before_traj_msg_).seconds(), true,
+        first_segment_coefficients_.data());
+      first_segment_ready_ = true;
+    }
+    evaluate_spline(
+      first_segment_coefficients_.data(), state_before_traj_msg_.positions.size(),
+      (sample_time - time_before_traj_msg_).seconds(), expected_state);
     start_segment_itr = begin();  // no segments before the first
     end_segment_itr = begin();
     return true;
@@ -106,38 +282,51 @@ bool Trajectory::sample(
 
   // time_from_start + trajectory time is the expected arrival time of trajectory
   const auto last_idx = trajectory_msg_->points.size() - 1;
-  for (auto i = 0ul; i < last_idx; ++i)
+  const int64_t time_from_start_ns = (sample_time - trajectory_start_time_).nanoseconds();
+  if (is_resampled() && time_from_start_ns < point_times_ns_[last_idx])
   {
-    const auto & point = trajectory_msg_->points[i];
-    const auto & next_point = trajectory_msg_->points[i + 1];
-
-    const rclcpp::Duration t0_offset = point.time_from_start;
-    const rclcpp::Duration t1_offset = next_point.time_from_start;
-    const rclcpp::Time t0 = trajectory_start_time_ + t0_offset;
-    const rclcpp::Time t1 = trajectory_start_time_ + t1_offset;
-
-    if (sample_time >= t0 && sample_time < t1)
-    {
-      interpolate_between_points(t0, point, t1, next_point, sample_time, expected_state);
-      start_segment_itr = begin() + i;
-      end_segment_itr = begin() + (i + 1);
-      return true;
-    }
+    const size_t i = sample_grid(time_from_start_ns, expected_state);
+    start_segment_itr = begin() + i;
+    end_segment_itr = begin() + (i + 1);
+    return true;
+  }
+  const size_t i = find_segment(time_from_start_ns);
+  if (i < last_idx)
+  {
+    evaluate_spline(
+      &segment_coefficients_[i * kSplineCoefficients * dim_], dim_,
+      1e-9 * static_cast<double>(time_from_start_ns - point_times_ns_[i]), expected_state);
+    start_segment_itr = begin() + i;
+    end_segment_itr = begin() + (i + 1);
+    return true;
   }
 
   // whole animation has played out
   start_segment_itr = --end();
   end_segment_itr = end();
-  expected_state = (*start_segment_itr);
+  // assign field by field, so the storage of expected_state is reused
+  const auto & last_point = *start_segment_itr;
+  const size_t dim = last_point.positions.size();
+  expected_state.positions = last_point.positions;
+  expected_state.effort = last_point.effort;
   // the trajectories in msg may have empty velocities/accel, so resize them
-  if (expected_state.velocities.empty())
+  if (last_point.velocities.empty())
   {
-    expected_state.velocities.resize(expected_state.positions.size(), 0.0);
+    expected_state.velocities.assign(dim, 0.0);
   }
-  if (expected_state.accelerations.empty())
+  else
   {
-    expected_state.accelerations.resize(expected_state.positions.size(), 0.0);
+    expected_state.velocities = last_point.velocities;
   }
+  if (last_point.accelerations.empty())
+  {
+    expected_state.accelerations.assign(dim, 0.0);
+  }
+  else
+  {
+    expected_state.accelerations = last_point.accelerations;
+  }
+  expected_state.time_from_start = last_point.time_from_start;
   return true;
 }
 
@@ -149,125 +338,205 @@ void Trajectory::interpolate_between_points(
   rclcpp::Duration duration_so_far = sample_time - time_a;
   rclcpp::Duration duration_btwn_points = time_b - time_a;
 
-  const size_t dim = state_a.positions.size();
-  output.positions.resize(dim, 0.0);
-  output.velocities.resize(dim, 0.0);
-  output.accelerations.resize(dim, 0.0);
-
-  auto generate_powers = [](int n, double x, double * powers) {
-    powers[0] = 1.0;
-    for (int i = 1; i <= n; ++i)
-    {
-      powers[i] = powers[i - 1] * x;
-    }
-  };
-
-  bool has_velocity = !state_a.velocities.empty() && !state_b.velocities.empty();
-  bool has_accel = !state_a.accelerations.empty() && !state_b.accelerations.empty();
+  // outside of the segment the position is clamped and only a linear interpolation is used
+  bool allow_higher_order = true;
   if (duration_so_far.seconds() < 0.0)
   {
     duration_so_far = rclcpp::Duration::from_seconds(0.0);
-    has_velocity = has_accel = false;
+    allow_higher_order = false;
   }
   if (duration_so_far.seconds() > duration_btwn_points.seconds())
   {
     duration_so_far = duration_btwn_points;
-    has_velocity = has_accel = false;
+    allow_higher_order = false;
   }
 
-  double t[6];
-  generate_powers(5, duration_so_far.seconds(), t);
-
-  if (!has_velocity && !has_accel)
+  // only grows, so that repeated calls with the same number of joints do not allocate
+  const size_t dim = state_a.positions.size();
+  if (interpolation_coefficients_.size() < kSplineCoefficients * dim)
   {
-    // do linear interpolation
-    for (size_t i = 0; i < dim; ++i)
-    {
-      double start_pos = state_a.positions[i];
-      double end_pos = state_b.positions[i];
+    interpolation_coefficients_.resize(kSplineCoefficients * dim);
+  }
+  compute_spline_coefficients(
+    state_a, state_b, duration_btwn_points.seconds(), allow_higher_order,
+    interpolation_coefficients_.data());
+  evaluate_spline(interpolation_coefficients_.data(), dim, duration_so_far.seconds(), output);
+}
 
-      double coefficients[2] = {0.0, 0.0};
-      coefficients[0] = start_pos;
-      if (duration_btwn_points.seconds() != 0.0)
-      {
-        coefficients[1] = (end_pos - start_pos) / duration_btwn_points.seconds();
-      }
+void compute_spline_coefficients(
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_b, double duration,
+  bool allow_higher_order, double * coefficients)
+{
+  const size_t dim = state_a.positions.size();
+  std::fill(coefficients, coefficients + kSplineCoefficients * dim, 0.0);
+  auto c = [coefficients, dim](size_t order, size_t joint) -> double & {
+    return coefficients[order * dim + joint];
+  };
 
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1];
-      output.velocities[i] = t[0] * coefficients[1];
-    }
+  const bool has_velocity =
+    allow_higher_order && !state_a.velocities.empty() && !state_b.velocities.empty();
+  const bool has_accel =
+    has_velocity && !state_a.accelerations.empty() && !state_b.accelerations.empty();
+
+  double T[6];
+  T[0] = 1.0;
+  for (size_t i = 1; i < 6; ++i)
+  {
+    T[i] = T[i - 1] * duration;
   }
-  else if (has_velocity && !has_accel)
+
+  for (size_t i = 0; i < dim; ++i)
   {
-    // do cubic interpolation
-    double T[4];
-    generate_powers(3, duration_btwn_points.seconds(), T);
+    const double start_pos = state_a.positions[i];
+    const double end_pos = state_b.positions[i];
+    c(0, i) = start_pos;
 
-    for (size_t i = 0; i < dim; ++i)
+    if (!has_velocity)
+    {
+      // linear interpolation
+      if (duration != 0.0)
+      {
+        c(1, i) = (end_pos - start_pos) / duration;
+      }
+    }
+    else if (!has_accel)
     {
-      double start_pos = state_a.positions[i];
-      double start_vel = state_a.velocities[i];
-      double end_pos = state_b.positions[i];
-      double end_vel = state_b.velocities[i];
-
-      double coefficients[4] = {0.0, 0.0, 0.0, 0.0};
-      coefficients[0] = start_pos;
-      coefficients[1] = start_vel;
-      if (duration_btwn_points.seconds() != 0.0)
+      // cubic interpolation
+      const double start_vel = state_a.velocities[i];
+      const double end_vel = state_b.velocities[i];
+      c(1, i) = start_vel;
+      if (duration != 0.0)
       {
-        coefficients[2] =
+        c(2, i) =
           (-3.0 * start_pos + 3.0 * end_pos - 2.0 * start_vel * T[1] - end_vel * T[1]) / T[2];
-        coefficients[3] =
-          (2.0 * start_pos - 2.0 * end_pos + start_vel * T[1] + end_vel * T[1]) / T[3];
+        c(3, i) = (2.0 * start_pos - 2.0 * end_pos + start_vel * T[1] + end_vel * T[1]) / T[3];
+      }
+    }
+    else
+    {
+      // quintic interpolation
+      const double start_vel = state_a.velocities[i];
+      const double start_acc = state_a.accelerations[i];
+      const double end_vel = state_b.velocities[i];
+      const double end_acc = state_b.accelerations[i];
+      c(1, i) = start_vel;
+      c(2, i) = 0.5 * start_acc;
+      if (duration != 0.0)
+      {
+        c(3, i) = (-20.0 * start_pos + 20.0 * end_pos - 3.0 * start_acc * T[2] +
+                   end_acc * T[2] - 12.0 * start_vel * T[1] - 8.0 * end_vel * T[1]) /
+                  (2.0 * T[3]);
+        c(4, i) = (30.0 * start_pos - 30.0 * end_pos + 3.0 * start_acc * T[2] -
+                   2.0 * end_acc * T[2] + 16.0 * start_vel * T[1] + 14.0 * end_vel * T[1]) /
+                  (2.0 * T[4]);
+        c(5, i) = (-12.0 * start_pos + 12.0 * end_pos - start_acc * T[2] + end_acc * T[2] -
+                   6.0 * start_vel * T[1] - 6.0 * end_vel * T[1]) /
+                  (2.0 * T[5]);
       }
-
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1] +
-                            t[2] * coefficients[2] + t[3] * coefficients[3];
-      output.velocities[i] =
-        t[0] * coefficients[1] + t[1] * 2.0 * coefficients[2] + t[2] * 3.0 * coefficients[3];
-      output.accelerations[i] = t[0] * 2.0 * coefficients[2] + t[1] * 6.0 * coefficients[3];
     }
   }
-  else if (has_velocity && has_accel)
+}
+
+void evaluate_spline(
+  const double * coefficients, size_t dim, double t,
+  trajectory_msgs::msg::JointTrajectoryPoint & output)
+{
+  output.positions.resize(dim);
+  output.velocities.resize(dim);
+  output.accelerations.resize(dim);
+  // splines carry no effort, clear() keeps the capacity for points which do
+  output.effort.clear();
+  double * pos = output.positions.data();
+  double * vel = output.velocities.data();
+  double * acc = output.accelerations.data();
+  const double * c0 = coefficients;
+  const double * c1 = c0 + dim;
+  const double * c2 = c1 + dim;
+  const double * c3 = c2 + dim;
+  const double * c4 = c3 + dim;
+  const double * c5 = c4 + dim;
+
+  // Horner's scheme, every loop runs over contiguous joint values
+  for (size_t i = 0; i < dim; ++i)
   {
-    // do quintic interpolation
-    double T[6];
-    generate_powers(5, duration_btwn_points.seconds(), T);
+    pos[i] = ((((c5[i] * t + c4[i]) * t + c3[i]) * t + c2[i]) * t + c1[i]) * t + c0[i];
+  }
+  for (size_t i = 0; i < dim; ++i)
+  {
+    vel[i] = (((5.0 * c5[i] * t + 4.0 * c4[i]) * t + 3.0 * c3[i]) * t + 2.0 * c2[i]) * t + c1[i];
+  }
+  for (size_t i = 0; i < dim; ++i)
+  {
+    acc[i] = ((20.0 * c5[i] * t + 12.0 * c4[i]) * t + 6.0 * c3[i]) * t + 2.0 * c2[i];
+  }
+}
 
+double compute_time_scale(
+  const trajectory_msgs::msg::JointTrajectory & trajectory,
+  const std::vector<double> & max_velocities, const std::vector<double> & max_accelerations,
+  int64_t step_ns, size_t & limiting_joint)
+{
+  double scale = 1.0;
+  limiting_joint = 0;
+  const auto & points = trajectory.points;
+  if (points.size() < 2 || step_ns <= 0)
+  {
+    return scale;
+  }
+  const size_t dim = points[0].positions.size();
+  auto check_limits = [&](const trajectory_msgs::msg::JointTrajectoryPoint & state) {
     for (size_t i = 0; i < dim; ++i)
     {
-      double start_pos = state_a.positions[i];
-      double start_vel = state_a.velocities[i];
-      double start_acc = state_a.accelerations[i];
-      double end_pos = state_b.positions[i];
-      double end_vel = state_b.velocities[i];
-      double end_acc = state_b.accelerations[i];
-
-      double coefficients[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-      coefficients[0] = start_pos;
-      coefficients[1] = start_vel;
-      coefficients[2] = 0.5 * start_acc;
-      if (duration_btwn_points.seconds() != 0.0)
+      // velocities scale with 1 / s, accelerations with 1 / s^2
+      const double velocity_scale =
+        max_velocities[i] > 0.0 ? std::abs(state.velocities[i]) / max_velocities[i] : 0.0;
+      const double acceleration_scale =
+        max_accelerations[i] > 0.0
+          ? std::sqrt(std::abs(state.accelerations[i]) / max_accelerations[i])
+          : 0.0;
+      if (std::max(velocity_scale, acceleration_scale) > scale)
       {
-        coefficients[3] = (-20.0 * start_pos + 20.0 * end_pos - 3.0 * start_acc * T[2] +
-                           end_acc * T[2] - 12.0 * start_vel * T[1] - 8.0 * end_vel * T[1]) /
-                          (2.0 * T[3]);
-        coefficients[4] = (30.0 * start_pos - 30.0 * end_pos + 3.0 * start_acc * T[2] -
-                           2.0 * end_acc * T[2] + 16.0 * start_vel * T[1] + 14.0 * end_vel * T[1]) /
-                          (2.0 * T[4]);
-        coefficients[5] = (-12.0 * start_pos + 12.0 * end_pos - start_acc * T[2] + end_acc * T[2] -
-                           6.0 * start_vel * T[1] - 6.0 * end_vel * T[1]) /
-                          (2.0 * T[5]);
+        scale = std::max(velocity_scale, acceleration_scale);
+        limiting_joint = i;
       }
+    }
+  };
 
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1] +
-                            t[2] * coefficients[2] + t[3] * coefficients[3] +
-                            t[4] * coefficients[4] + t[5] * coefficients[5];
-      output.velocities[i] = t[0] * coefficients[1] + t[1] * 2.0 * coefficients[2] +
-                             t[2] * 3.0 * coefficients[3] + t[3] * 4.0 * coefficients[4] +
-                             t[4] * 5.0 * coefficients[5];
-      output.accelerations[i] = t[0] * 2.0 * coefficients[2] + t[1] * 6.0 * coefficients[3] +
-                                t[2] * 12.0 * coefficients[4] + t[3] * 20.0 * coefficients[5];
+  std::vector<double> coefficients(kSplineCoefficients * dim);
+  trajectory_msgs::msg::JointTrajectoryPoint state;
+  for (size_t i = 0; i + 1 < points.size(); ++i)
+  {
+    const int64_t duration_ns = (rclcpp::Duration(points[i + 1].time_from_start) -
+                                 rclcpp::Duration(points[i].time_from_start))
+                                  .nanoseconds();
+    compute_spline_coefficients(
+      points[i], points[i + 1], 1e-9 * static_cast<double>(duration_ns), true, coefficients.data());
+    for (int64_t t = 0; t < duration_ns; t += step_ns)
+    {
+      evaluate_spline(coefficients.data(), dim, 1e-9 * static_cast<double>(t), state);
+      check_limits(state);
+    }
+    evaluate_spline(coefficients.data(), dim, 1e-9 * static_cast<double>(duration_ns), state);
+    check_limits(state);
+  }
+  return scale;
+}
+
+void scale_trajectory_time(trajectory_msgs::msg::JointTrajectory & trajectory, double scale)
+{
+  for (auto & point : trajectory.points)
+  {
+    const auto time_ns = rclcpp::Duration(point.time_from_start).nanoseconds();
+    point.time_from_start = rclcpp::Duration(
+      std::chrono::nanoseconds(std::llround(scale * static_cast<double>(time_ns))));
+    for (auto & velocity : point.velocities)
+    {
+      velocity /= scale;
+    }
+    for (auto & acceleration : point.accelerations)
+    {
+      acceleration /= scale * scale;
     }
   }
 }